@@ -70,6 +70,7 @@ using LibraryVersion = enum class LibraryVersion : int
 #cmakedefine	HAVE_DUP2		@HAVE_DUP2@
 #cmakedefine	HAVE_EPOLL		@HAVE_EPOLL@
 #cmakedefine	HAVE_EPOLL_CREATE1	@HAVE_EPOLL_CREATE1@
+#cmakedefine	HAVE_EVENTFD		@HAVE_EVENTFD@
 #cmakedefine	HAVE_FCNTL_H		@HAVE_FCNTL_H@
 #cmakedefine	HAVE_FDATASYNC		@HAVE_FDATASYNC@
 #cmakedefine	HAVE_FMODL		@HAVE_FMODL@
@@ -100,15 +101,18 @@ using LibraryVersion = enum class LibraryVersion : int
 #cmakedefine	HAVE_INT128_T_GNU		@HAVE_INT128_T_GNU@
 #cmakedefine	HAVE_INTTYPES_H		@HAVE_INTTYPES_H@
 #cmakedefine	HAVE_IN_PKTINFO_STRUCT		@HAVE_IN_PKTINFO_STRUCT@
+#cmakedefine	HAVE_IO_URING		@HAVE_IO_URING@
 #cmakedefine	HAVE_ISASCII		@HAVE_ISASCII@
 #cmakedefine	HAVE_JSONCPP		@HAVE_JSONCPP@
 #cmakedefine	HAVE_KQUEUE			@HAVE_KQUEUE@
 #cmakedefine	HAVE_LIBPTHREAD		@HAVE_LIBPTHREAD@
 #cmakedefine	HAVE_LIBPTHREADS		@HAVE_LIBPTHREADS@
 #cmakedefine	HAVE_LIMITS_H		@HAVE_LIMITS_H@
+#cmakedefine	HAVE_LINUX_FUTEX_H		@HAVE_LINUX_FUTEX_H@
 #cmakedefine	HAVE_LOCALTIME_R		@HAVE_LOCALTIME_R@
 #cmakedefine	HAVE_MALLOC		@HAVE_MALLOC@
 #cmakedefine	HAVE_MEMCHR		@HAVE_MEMCHR@
+#cmakedefine	HAVE_MEMFD_CREATE		@HAVE_MEMFD_CREATE@
 #cmakedefine	HAVE_MEMMOVE		@HAVE_MEMMOVE@
 #cmakedefine	HAVE_MEMORY_H		@HAVE_MEMORY_H@
 #cmakedefine	HAVE_MEMSET		@HAVE_MEMSET@
@@ -169,6 +173,7 @@ using LibraryVersion = enum class LibraryVersion : int
 #cmakedefine	HAVE_SYS_TYPES_H		@HAVE_SYS_TYPES_H@
 #cmakedefine	HAVE_SYS_VFS_H		@HAVE_SYS_VFS_H@
 #cmakedefine	HAVE_SYS_WAIT_H		@HAVE_SYS_WAIT_H@
+#cmakedefine	HAVE_TIMERFD		@HAVE_TIMERFD@
 #cmakedefine	HAVE_TIMESPEC_STRUCT		@HAVE_TIMESPEC_STRUCT@
 #cmakedefine	HAVE_TZSET		@HAVE_TZSET@
 #cmakedefine	HAVE_UNAME		@HAVE_UNAME@
@@ -44,6 +44,12 @@ namespace pw
 
 static ChannelMapTemplate<ChannelInterface> s_channels;
 
+//! \brief 현재 스레드에서 만든 채널 개수
+static thread_local size_t t_local_count(0);
+
+//! \brief 엣지 트리거 채널의 이벤트당 읽기 예산
+static size_t s_read_budget(ChannelInterface::DEFAULT_READ_BUDGET);
+
 chif_create_type::chif_create_type (int _fd, IoPoller* _poller, const SslContext* _ctx, size_t _bufsize, void* _append) : fd(_fd), poller(_poller), ssl(_ctx ? Ssl::s_create(_ctx):nullptr), bufsize(_bufsize), append(_append)
 {
 }
@@ -56,6 +62,9 @@ chif_create_type::dump ( std::ostream& os ) const
 		" poller: " << poller <<
 		" ssl: " << ssl <<
 		" bufsize: " << bufsize <<
+		" rbuf_type: " << int(rbuf_type) <<
+		" wbuf_type: " << int(wbuf_type) <<
+		" lazy: " << lazy <<
 		" append: " << append << endl;
 
 	return os;
@@ -154,6 +163,7 @@ ChannelInterface::ChannelInterface() :
 //	m_check_type(Check::NONE),
 	m_unique_name(s_channels.insert(this))
 {
+	++t_local_count;
 	do
 	{
 		m_rbuf = new IoBuffer(IoBuffer::DEFAULT_SIZE, IoBuffer::DEFAULT_DELTA);
@@ -175,8 +185,10 @@ ChannelInterface::ChannelInterface(const chif_create_type& param) :
 //	m_inst_state(InstanceState::NORMAL),
 //	m_conn_state(ConnectState::NONE),
 //	m_check_type(Check::NONE),
+	m_lazy(param.lazy),
 	m_unique_name(s_channels.insert(this))
 {
+	++t_local_count;
 	do
 	{
 		if ( m_ssl )
@@ -188,8 +200,8 @@ ChannelInterface::ChannelInterface(const chif_create_type& param) :
 		else
 		{
 			PWTRACE("PLAIN type");
-			m_rbuf = new IoBuffer(param.bufsize, IoBuffer::DEFAULT_DELTA);
-			m_wbuf = new IoBuffer(IoBuffer::DEFAULT_SIZE, IoBuffer::DEFAULT_DELTA);
+			m_rbuf = IoBuffer::s_create(param.rbuf_type, param.bufsize, IoBuffer::DEFAULT_DELTA);
+			m_wbuf = IoBuffer::s_create(param.wbuf_type, IoBuffer::DEFAULT_SIZE, IoBuffer::DEFAULT_DELTA);
 		}
 
 		if ( (not m_rbuf) or (not m_wbuf) )
@@ -197,6 +209,8 @@ ChannelInterface::ChannelInterface(const chif_create_type& param) :
 			PWLOGLIB("failed to create buffer: channel:%p", this);
 			break;
 		}
+
+		if ( m_lazy ) _detachBuffer();
 	} while (false);
 
 	if ( m_fd >= 0 )
@@ -212,6 +226,31 @@ ChannelInterface::~ChannelInterface()
 	if ( m_ssl ) { Ssl::s_release(m_ssl); m_ssl = nullptr; }
 
 	s_channels.erase(m_unique_name);
+	if ( t_local_count > 0 ) --t_local_count;
+}
+
+size_t
+ChannelInterface::s_getCount(void)
+{
+	return s_channels.size();
+}
+
+size_t
+ChannelInterface::s_getLocalCount(void)
+{
+	return t_local_count;
+}
+
+void
+ChannelInterface::s_setReadBudget(size_t budget)
+{
+	s_read_budget = std::max(budget, size_t(1));
+}
+
+size_t
+ChannelInterface::s_getReadBudget(void)
+{
+	return s_read_budget;
 }
 
 std::ostream&
@@ -542,6 +581,7 @@ ChannelInterface::clearInstance(void)
 	}
 
 	m_inst_state = InstanceState::NORMAL;
+	m_edge = false;
 	setConnNone();
 
 	m_rbuf->clear();
@@ -559,6 +599,7 @@ ChannelInterface::setExpired(void)
 	}
 
 	m_inst_state = InstanceState::EXPIRED;
+	m_edge = false;
 
 	if ( m_fd != -1 )
 	{
@@ -582,6 +623,7 @@ ChannelInterface::setRelease(void)
 	}
 
 	m_inst_state = InstanceState::DELETE;
+	m_edge = false;
 
 	if ( m_fd != -1 )
 	{
@@ -634,6 +676,20 @@ ChannelInterface::eventIo(int fd, int event, bool&/* del_event */)
 			break;
 		}
 
+		if ( (not m_edge) and (not isInstExpired()) and m_poller->isEdgeTriggered() )
+		{
+			setEdgeTriggered();
+		}
+
+		if ( m_edge )
+		{
+			// 엣지 트리거는 같은 이벤트를 다시 알려주지 않으므로 읽기와 쓰기를 모두 처리한다.
+			if ( event bitand (POLLIN bitor POLLERR bitor POLLHUP bitor POLLNVAL) ) eventRead(event);
+			if ( isInstDelete() ) break;
+			if ( m_edge and (event bitand POLLOUT) ) eventWrite(event);
+			break;
+		}
+
 		if( event bitand POLLIN )
 		{
 			if ( isInstExpired() )
@@ -663,6 +719,7 @@ ChannelInterface::eventIo(int fd, int event, bool&/* del_event */)
 		}
 	} while(false);
 
+	if ( m_lazy ) _detachBuffer();
 	if ( isInstDelete() ) releaseInstance();
 }
 
@@ -761,12 +818,61 @@ ChannelInterface::eventConnecting(void)
 	}
 }
 
+bool
+ChannelInterface::setEdgeTriggered(void)
+{
+	if ( (m_fd < 0) or (nullptr == m_poller) or (not m_poller->isEdgeTriggered()) ) return false;
+
+	m_edge = m_poller->setMask(m_fd, POLLIN bitor POLLOUT bitor IoPoller::EDGE);
+	return m_edge;
+}
+
+bool
+ChannelInterface::flushWriteBuffer(void)
+{
+	ssize_t len(0);
+	while ( not m_wbuf->isEmpty() )
+	{
+		if ( (len = m_wbuf->writeToFile(m_fd)) > 0 )
+		{
+			eventWriteData(size_t(len));
+			continue;
+		}
+
+		return s_isAgain(errno);
+	}
+
+	m_wbuf->flush();
+	return true;
+}
+
 void
 ChannelInterface::eventRead(int event)
 {
 	//PWSHOWMETHOD();
 	ssize_t len;
-	if ( (len = m_rbuf->readFromFile(m_fd)) > 0 )
+	if ( m_edge )
+	{
+		// EAGAIN까지 읽되, 예산을 넘으면 나머지는 다음 턴에 읽는다.
+		const size_t budget(s_read_budget);
+		size_t sum(0);
+		while ( (len = _readFromFile()) > 0 )
+		{
+			eventReadData(size_t(len));
+			if ( (not m_edge) or (m_fd < 0) or isInstDeleteOrExpired() ) return;
+			if ( (sum += size_t(len)) >= budget )
+			{
+				m_poller->requeue(m_fd);
+				return;
+			}
+		}
+	}
+	else
+	{
+		len = _readFromFile();
+	}
+
+	if ( len > 0 )
 	{
 		eventReadData(size_t(len));
 	}
@@ -801,7 +907,7 @@ ChannelInterface::eventWrite(int event)
 			//PWTRACE("expired! setRelease!");
 			setRelease();
 		}
-		else
+		else if ( not m_edge )
 		{
 			m_poller->setMask(m_fd, POLLIN);
 			// 아래 구문 대신 setMask로 대체
@@ -820,6 +926,18 @@ ChannelInterface::eventWrite(int event)
 		}
 	}
 
+	if ( m_edge )
+	{
+		// 마스크는 그대로 두고 EAGAIN까지 쓴다.
+		if ( not flushWriteBuffer() )
+		{
+			m_wbuf->clear();
+			eventError(Error::WRITE, errno);
+		}
+
+		return;
+	}
+
 	const size_t count(getEventDispatchCount());
 	size_t i(0);
 	ssize_t len(0);
@@ -887,10 +1005,9 @@ ChannelInterface::write(const PacketInterface& pk)
 {
 	if ( isInstDeleteOrExpired() ) return false;
 	if ( (m_fd == -1) or (m_poller == nullptr) or (m_wbuf == nullptr) ) return false;
+	const bool was_empty(m_wbuf->isEmpty());
 	if ( pk.write(*m_wbuf) <= 0 ) return false;
-	m_poller->orMask(m_fd, POLLOUT);
-
-	return true;
+	return _armWrite(was_empty);
 }
 
 bool
@@ -898,12 +1015,69 @@ ChannelInterface::write(const char* buf, size_t blen)
 {
 	if ( isInstDeleteOrExpired() ) return false;
 	if ( (m_fd == -1) or (m_poller == nullptr) or (m_wbuf == nullptr) ) return false;
+	const bool was_empty(m_wbuf->isEmpty());
 	if ( size_t(m_wbuf->writeToBuffer(buf, blen)) != blen ) return false;
-	m_poller->orMask(m_fd, POLLOUT);
+	return _armWrite(was_empty);
+}
+
+bool
+ChannelInterface::_armWrite(bool was_empty)
+{
+	// 버퍼가 비어 있었으면 폴러를 거치지 않고 바로 써 보고,
+	// 남은 데이터가 있을 때만 쓰기 이벤트를 기다린다.
+	// 엣지 트리거에서는 남은 데이터가 있으면 EAGAIN 이후 쓰기 이벤트가 반드시 온다.
+	if ( was_empty and isConnSuccess() )
+	{
+		if ( not flushWriteBuffer() )
+		{
+			// 오류 처리는 다음 쓰기 이벤트에서 한다.
+			m_edge = false;
+			m_poller->setMask(m_fd, POLLIN bitor POLLOUT);
+			return true;
+		}
+
+		if ( m_wbuf->isEmpty() )
+		{
+			if ( m_lazy ) m_wbuf->detach();
+			return true;
+		}
+	}
+
+	if ( not m_edge ) m_poller->orMask(m_fd, POLLOUT);
 
 	return true;
 }
 
+ssize_t
+ChannelInterface::_readFromFile(void)
+{
+	if ( m_lazy and (nullptr == m_ssl) and (not m_rbuf->isAttached()) )
+	{
+		// 유휴 채널은 스크래치에 먼저 읽고, 읽은 것이 있을 때만 버퍼를 붙인다.
+		char scratch[LAZY_SCRATCH_SIZE];
+		const ssize_t len(::read(m_fd, scratch, sizeof(scratch)));
+		if ( len > 0 )
+		{
+			if ( m_rbuf->writeToBuffer(scratch, size_t(len)) not_eq len )
+			{
+				errno = ENOMEM;
+				return ssize_t(-1);
+			}
+		}
+
+		return len;
+	}
+
+	return m_rbuf->readFromFile(m_fd);
+}
+
+void
+ChannelInterface::_detachBuffer(void)
+{
+	if ( m_rbuf ) m_rbuf->detach();
+	if ( m_wbuf ) m_wbuf->detach();
+}
+
 bool
 ChannelInterface::getLineSync(std::string& out, size_t limit/* = size_t(-1)*/)
 {
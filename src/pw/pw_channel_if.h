@@ -52,6 +52,9 @@ struct chif_create_type final
 	mutable IoPoller*	poller{nullptr};		//!< 폴러
 	mutable Ssl*			ssl{nullptr};		//!< Ssl channel
 	size_t					bufsize{IoBuffer::DEFAULT_SIZE};	//!< 버퍼 크기
+	IoBuffer::Type			rbuf_type{IoBuffer::Type::LINEAR};	//!< 읽기 버퍼 형태. SSL 채널은 무시한다.
+	IoBuffer::Type			wbuf_type{IoBuffer::Type::LINEAR};	//!< 쓰기 버퍼 형태. SSL 채널은 무시한다.
+	bool					lazy{false};	//!< 버퍼가 비면 저장소를 풀에 돌려준다.
 
 	mutable void*			append{nullptr};		//!< 추가 설정
 
@@ -121,6 +124,8 @@ public:
 	enum
 	{
 		SOCKBUF_SIZE_CHECK = 1024*500,	//!< 소켓버퍼 검사 시 임계값
+		LAZY_SCRATCH_SIZE = 1024*4,	//!< 지연 할당 채널의 첫 읽기 크기
+		DEFAULT_READ_BUDGET = 1024*256,	//!< 엣지 트리거에서 이벤트 한 번에 읽는 기본 최대 크기
 	};
 
 public:
@@ -136,6 +141,17 @@ public:
 	//! \brief 전체 채널 개수를 반환한다.
 	static size_t s_getCount(void);
 
+	//! \brief 현재 스레드에서 만든 채널 개수를 반환한다.
+	//! \details 차일드 부하로 쓴다. 채널은 만든 스레드에서 지워야 정확하다.
+	static size_t s_getLocalCount(void);
+
+	//! \brief 엣지 트리거 채널이 이벤트 한 번에 읽을 최대 크기를 설정한다.
+	//! \details 넘으면 나머지는 다음 폴러 턴에 읽어서, 빠르게 보내는 채널 하나가 다른 채널을 굶기지 않는다.
+	static void s_setReadBudget(size_t budget);
+
+	//! \brief 엣지 트리거 채널이 이벤트 한 번에 읽을 최대 크기
+	static size_t s_getReadBudget(void);
+
 	//! \brief 디버그를 위한 채널 내용을 덤프한다.
 	virtual std::ostream& dump(std::ostream& os) const;
 
@@ -206,6 +222,12 @@ public:
 	inline void setCheckRead(void) { m_check_type = Check::READ; }
 	inline void setCheckBoth(void) { m_check_type = Check::BOTH; }
 
+	//! \brief 폴러에 엣지 트리거로 등록했는지 확인한다.
+	inline bool isEdgeTriggered(void) const { return m_edge; }
+
+	//! \brief 버퍼 지연 할당 여부
+	inline bool isLazyBuffer(void) const { return m_lazy; }
+
 public:
 	virtual bool write(const PacketInterface& pk);
 	virtual bool write(const char* buf, size_t blen);
@@ -313,9 +335,24 @@ protected:
 
 	virtual bool procConnect(const char* host, const char* service, int family, bool async);
 
+	//! \brief 엣지 트리거를 지원하는 폴러면 읽기/쓰기를 한 번에 등록한다.
+	bool setEdgeTriggered(void);
+
+	//! \brief 쓰기 버퍼를 비우거나 EAGAIN이 날 때까지 소켓에 쓴다.
+	//! \return 소켓 오류일 경우 false.
+	bool flushWriteBuffer(void);
+
 	//! \brief IoPoller::Client에서 상속
 	void eventIo(int fd, int event, bool& del_event) override;
 
+	//! \brief 쓰기 버퍼에 데이터를 넣은 뒤 호출한다. 바로 쓰거나 쓰기 이벤트를 기다린다.
+	//! \param[in] was_empty 넣기 전에 쓰기 버퍼가 비어 있었는지 여부
+	bool _armWrite(bool was_empty);
+
+private:
+	ssize_t _readFromFile(void);
+	void _detachBuffer(void);
+
 protected:
 	Ssl*				m_ssl;	//!< Ssl session
 	IoBuffer*			m_rbuf;	//!< Read buffer
@@ -326,6 +363,8 @@ protected:
 	ConnectState	m_conn_state = ConnectState::NONE;		//!< Connection state
 	RecvState		m_recv_state = RecvState::START;		//!< Recv state
 	Check			m_check_type = Check::NONE;				//!< Overflow check type
+	bool			m_edge = false;							//!< Edge triggered
+	bool			m_lazy = false;							//!< Lazy buffer
 
 private:
 	const ch_name_type		m_unique_name;	//!< Channel unique name
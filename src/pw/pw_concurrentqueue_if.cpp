@@ -30,6 +30,59 @@
 
 #include "./pw_concurrentqueue_if.h"
 
+#ifdef HAVE_LINUX_FUTEX_H
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#endif
+
 namespace pw {
 
+bool
+ConcurrentWaiter::wait(uint32_t seq, int64_t timeout_msec)
+{
+#ifdef HAVE_LINUX_FUTEX_H
+	struct timespec ts, *pts(nullptr);
+	if ( timeout_msec >= 0 )
+	{
+		ts.tv_sec = time_t(timeout_msec / 1000LL);
+		ts.tv_nsec = long((timeout_msec % 1000LL) * 1000000LL);
+		pts = &ts;
+	}
+
+	// 세대가 이미 바뀌었으면 EAGAIN으로 바로 돌아온다.
+	if ( -1 == ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_seq), FUTEX_WAIT_PRIVATE, seq, pts, nullptr, 0) )
+	{
+		return ETIMEDOUT not_eq errno;
+	}
+
+	return true;
+#else
+	std::unique_lock<std::mutex> locked(m_lock);
+	if ( timeout_msec < 0 )
+	{
+		m_cv.wait(locked, [this, seq]{ return m_seq.load() not_eq seq; });
+		return true;
+	}
+
+	return m_cv.wait_for(locked, std::chrono::milliseconds(timeout_msec), [this, seq]{ return m_seq.load() not_eq seq; });
+#endif
+}
+
+void
+ConcurrentWaiter::_wake(size_t count)
+{
+#ifdef HAVE_LINUX_FUTEX_H
+	m_seq.fetch_add(1);
+	::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_seq), FUTEX_WAKE_PRIVATE, int(std::min(count, size_t(INT_MAX))), nullptr, nullptr, 0);
+#else
+	{
+		std::unique_lock<std::mutex> locked(m_lock);
+		m_seq.fetch_add(1);
+	}
+
+	if ( 1 == count ) m_cv.notify_one();
+	else m_cv.notify_all();
+#endif
+}
+
 };//namespace pw
@@ -30,6 +30,8 @@
 
 #include "./pw_common.h"
 
+#include <atomic>
+
 #ifndef __PW_CONCURRENTQUEUE_H__
 #define __PW_CONCURRENTQUEUE_H__
 
@@ -241,6 +243,371 @@ private:
 
 }; //template class ConcurrentQueueTemplate
 
+//! \brief 락 없는 다중 생산자, 단일 소비자 큐 템플릿
+//! \details 생산자는 CAS로 스택에 넣고, 소비자는 스택을 통째로 떼어 넣은 순서대로 처리한다.
+//!	소비자가 한 번에 모두 꺼내므로 스레드 작업 결과를 이벤트 루프로 넘길 때 적합하다.
+//! \warning drain은 한 스레드에서만 호출한다.
+template<typename _Type>
+class MpscQueueTemplate final
+{
+public:
+	using value_type = _Type;						//!< Value type
+
+private:
+	struct node_type
+	{
+		value_type	value;
+		node_type*	next;
+
+		template<typename... _Args>
+		inline explicit node_type(_Args&&... args) : value(std::forward<_Args>(args)...), next(nullptr) {}
+	};
+
+private:
+	std::atomic<node_type*> m_head { nullptr };
+
+public:
+	MpscQueueTemplate() = default;
+	~MpscQueueTemplate() { clear(); }
+
+	MpscQueueTemplate(const MpscQueueTemplate&) = delete;
+	MpscQueueTemplate& operator = (const MpscQueueTemplate&) = delete;
+
+public:
+	//! \brief 큐에 하나를 넣는다. 스레드에 안전하다.
+	//! \return 큐가 비어 있었다면 참을 반환한다. 소비자를 깨울 때 사용한다.
+	template<typename... _Args>
+	bool push(_Args&&... args)
+	{
+		node_type* node(new node_type(std::forward<_Args>(args)...));
+		node_type* head(m_head.load(std::memory_order_relaxed));
+		do {
+			node->next = head;
+		} while ( not m_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed) );
+
+		return nullptr == head;
+	}
+
+	//! \brief 큐에 있는 것을 모두 꺼내 넣은 순서대로 처리한다.
+	//! \param[in] func void(value_type&) 형식의 함수
+	//! \return 처리한 개수
+	template<typename _Func>
+	size_t drain(_Func&& func)
+	{
+		node_type* node(m_head.exchange(nullptr, std::memory_order_acquire));
+		if ( nullptr == node ) return 0;
+
+		// 스택 순서를 뒤집어 넣은 순서로 만든다.
+		node_type* prev(nullptr);
+		while ( node )
+		{
+			node_type* next(node->next);
+			node->next = prev;
+			prev = node;
+			node = next;
+		}
+
+		size_t count(0);
+		while ( prev )
+		{
+			node = prev;
+			prev = prev->next;
+			func(node->value);
+			delete node;
+			++count;
+		}
+
+		return count;
+	}
+
+	//! \brief 큐를 비운다.
+	inline void clear(void) { drain([](value_type&){}); }
+
+	//! \brief 큐가 비어 있는지 확인한다.
+	inline bool empty(void) const { return nullptr == m_head.load(std::memory_order_acquire); }
+}; //template class MpscQueueTemplate
+
+//! \brief 락 없는 큐에서 기다리는 스레드를 재우고 깨운다.
+//! \details 리눅스에서는 futex를 사용하고, 그 밖에는 조건 변수를 사용한다.
+//!	기다리는 스레드가 없으면 notify는 시스템 콜을 하지 않는다.
+//!	기다리는 쪽은 prepare 후 조건을 다시 확인하고, 그래도 안 되면 wait, 끝나면 finish를 부른다.
+class ConcurrentWaiter final
+{
+public:
+	ConcurrentWaiter() = default;
+	~ConcurrentWaiter() = default;
+
+	ConcurrentWaiter(const ConcurrentWaiter&) = delete;
+	ConcurrentWaiter& operator = (const ConcurrentWaiter&) = delete;
+
+public:
+	//! \brief 기다리기 전에 호출한다.
+	//! \return wait에 넘길 세대
+	inline uint32_t prepare(void)
+	{
+		m_waiters.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return m_seq.load();
+	}
+
+	//! \brief 세대가 바뀔 때까지 기다린다.
+	//! \param[in] timeout_msec 음수면 무기한 기다린다.
+	//! \return 시간을 넘겼으면 거짓을 반환한다. 가짜로 깰 수 있으므로 조건은 다시 확인한다.
+	bool wait(uint32_t seq, int64_t timeout_msec = -1);
+
+	//! \brief 기다리기를 마친다. prepare마다 한 번 호출한다.
+	inline void finish(void) { m_waiters.fetch_sub(1); }
+
+	//! \brief 기다리는 스레드를 count개까지 깨운다.
+	inline void notify(size_t count = 1)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if ( m_waiters.load(std::memory_order_relaxed) ) _wake(count);
+	}
+
+private:
+	void _wake(size_t count);
+
+private:
+	std::atomic<uint32_t>	m_seq { 0 };
+	std::atomic<uint32_t>	m_waiters { 0 };
+#ifndef HAVE_LINUX_FUTEX_H
+	std::mutex	m_lock;
+	std::condition_variable	m_cv;
+#endif
+};
+
+//! \brief 락 없는 크기 제한 다중 생산자, 다중 소비자 링 큐 템플릿
+//! \details ConcurrentQueueTemplate과 같은 방식으로 사용하지만, 미리 할당한 링을 사용하므로
+//!	넣고 뺄 때 메모리 할당과 락이 없다. 칸마다 순번을 두어 생산자와 소비자가 CAS로 자리를 얻는다.
+//!	큐가 가득 차면 push는 바로 실패한다. 비어 있을 때 pop은 ConcurrentWaiter로 기다린다.
+//! \warning value_type은 기본 생성과 이동 대입이 가능해야 한다.
+template<typename _Type>
+class ConcurrentRingQueueTemplate final
+{
+public:
+	using value_type = _Type;						//!< Value type
+	using reference_type = _Type&;					//!< Reference type
+	using moveable_type = _Type&&;					//!< Movable type
+	using pointer_type = _Type*;					//!< Pointer type
+
+	enum
+	{
+		CACHE_LINE_SIZE = 64,
+		DEFAULT_CAPACITY = 1024,
+		SPIN_COUNT = 128,	//!< 잠들기 전에 다시 시도하는 횟수
+	};
+
+private:
+	struct cell_type
+	{
+		std::atomic<size_t>	seq;
+		value_type			value;
+	};
+
+	using pos_type = std::atomic<size_t>;
+
+private:
+	cell_type*	m_cells { nullptr };
+	size_t		m_mask { 0 };
+
+	// 생산자와 소비자 위치가 같은 캐시 라인을 쓰지 않도록 떨어뜨려 둔다.
+	char		m_pad0[CACHE_LINE_SIZE];
+	pos_type	m_push_pos { 0 };
+	char		m_pad1[CACHE_LINE_SIZE - sizeof(pos_type)];
+	pos_type	m_pop_pos { 0 };
+	char		m_pad2[CACHE_LINE_SIZE - sizeof(pos_type)];
+	ConcurrentWaiter	m_waiter;
+
+public:
+	//! \brief 용량은 2의 거듭제곱으로 올린다.
+	explicit ConcurrentRingQueueTemplate(size_t capacity = DEFAULT_CAPACITY)
+	{
+		size_t cap(2);
+		while ( cap < capacity ) cap <<= 1;
+
+		m_cells = new cell_type[cap];
+		m_mask = cap - 1;
+		for ( size_t i(0); i < cap; i++ ) m_cells[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+	~ConcurrentRingQueueTemplate() { delete [] m_cells; }
+
+	ConcurrentRingQueueTemplate(const ConcurrentRingQueueTemplate&) = delete;
+	ConcurrentRingQueueTemplate& operator = (const ConcurrentRingQueueTemplate&) = delete;
+
+public:
+	//! \brief 큐에서 하나를 꺼내온다.
+	//! 큐가 비어 있으면 무기한 기다린다.
+	inline value_type pop(void)
+	{
+		value_type ret;
+		pop(ret);
+		return ret;
+	}
+
+	//! \brief 큐에서 하나를 꺼내온다.
+	//! 큐가 비어 있으면 무기한 기다린다.
+	void pop(value_type& ret)
+	{
+		while ( not _popSpin(ret) )
+		{
+			const uint32_t seq(m_waiter.prepare());
+			if ( popTry(ret) )
+			{
+				m_waiter.finish();
+				return;
+			}
+
+			m_waiter.wait(seq);
+			m_waiter.finish();
+		}
+	}
+
+	//! \brief 큐에서 시간 내에 하나를 꺼내온다.
+	//! \return 시간을 넘겼을 경우, 거짓을 반환한다.
+	bool popTimed(value_type& ret, unsigned long msec)
+	{
+		if ( _popSpin(ret) ) return true;
+		if ( not msec ) return false;
+
+		using clock_type = std::chrono::steady_clock;
+		const clock_type::time_point dest_limit { clock_type::now() + std::chrono::milliseconds(msec) };
+
+		while ( true )
+		{
+			const uint32_t seq(m_waiter.prepare());
+			if ( popTry(ret) )
+			{
+				m_waiter.finish();
+				return true;
+			}
+
+			const int64_t left(std::chrono::duration_cast<std::chrono::milliseconds>(dest_limit - clock_type::now()).count());
+			const bool waked( (left > 0) and m_waiter.wait(seq, left) );
+			m_waiter.finish();
+
+			if ( popTry(ret) ) return true;
+			if ( not waked ) return false;
+		}
+	}
+
+	//! \brief 큐에서 하나를 꺼내온다.
+	//! 큐가 비어 있으면 바로 실패를 반환한다.
+	bool popTry(value_type& ret)
+	{
+		cell_type* cell;
+		size_t pos(m_pop_pos.load(std::memory_order_relaxed));
+		while ( true )
+		{
+			cell = &m_cells[pos bitand m_mask];
+			const intptr_t dif( intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos + 1) );
+			if ( 0 == dif )
+			{
+				if ( m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) break;
+			}
+			else if ( dif < 0 ) return false;
+			else pos = m_pop_pos.load(std::memory_order_relaxed);
+		}
+
+		ret = std::move(cell->value);
+		cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	//! \brief 큐에서 max개까지 꺼내온다. 기다리지 않는다.
+	//! \return 꺼낸 개수
+	size_t popN(value_type* out, size_t max)
+	{
+		size_t count(0);
+		while ( (count < max) and popTry(out[count]) ) ++count;
+		return count;
+	}
+
+	//! \brief 큐에 하나를 넣는다.
+	//! 성공하면, pop하는 스레드를 깨운다.
+	inline bool push(const value_type& r)
+	{
+		if ( not _push(r) ) return false;
+		m_waiter.notify();
+		return true;
+	}
+
+	//! \brief 큐에 하나를 넣는다.
+	//! 성공하면, pop하는 스레드를 깨운다.
+	inline bool push(value_type&& r)
+	{
+		if ( not _push(std::move(r)) ) return false;
+		m_waiter.notify();
+		return true;
+	}
+
+	//! \brief 큐에 count개를 넣는다. 가득 차면 거기서 멈춘다.
+	//! 넣은 만큼 pop하는 스레드를 깨운다.
+	//! \return 넣은 개수
+	size_t pushN(const value_type* items, size_t count)
+	{
+		size_t ret(0);
+		while ( (ret < count) and _push(items[ret]) ) ++ret;
+		if ( ret ) m_waiter.notify(ret);
+		return ret;
+	}
+
+public:
+	//! \brief 큐가 비어 있는지 확인한다. 다른 스레드가 사용 중이면 근사값이다.
+	inline bool empty(void) const { return 0 == size(); }
+
+	//! \brief 큐를 비운다.
+	//! \warning pop하는 스레드를 깨우지 않는다.
+	inline void clear(void) { value_type tmp; while ( popTry(tmp) ) {} }
+
+	//! \brief 큐 아이템 개수를 반환한다. 다른 스레드가 사용 중이면 근사값이다.
+	inline size_t size(void) const
+	{
+		const size_t pop_pos(m_pop_pos.load(std::memory_order_acquire));
+		const size_t push_pos(m_push_pos.load(std::memory_order_acquire));
+		return push_pos > pop_pos ? push_pos - pop_pos : 0;
+	}
+
+	//! \brief 큐 용량
+	inline size_t getMaxSize(void) const { return m_mask + 1; }
+
+private:
+	//! \brief 잠들면 시스템 콜이 드므로, 곧 들어올 아이템을 잠시 기다려 본다.
+	bool _popSpin(value_type& ret)
+	{
+		for ( size_t i(0); i < SPIN_COUNT; i++ )
+		{
+			if ( popTry(ret) ) return true;
+			if ( m_push_pos.load(std::memory_order_relaxed) == m_pop_pos.load(std::memory_order_relaxed) ) std::this_thread::yield();
+		}
+
+		return false;
+	}
+
+	template<typename _Value>
+	bool _push(_Value&& v)
+	{
+		cell_type* cell;
+		size_t pos(m_push_pos.load(std::memory_order_relaxed));
+		while ( true )
+		{
+			cell = &m_cells[pos bitand m_mask];
+			const intptr_t dif( intptr_t(cell->seq.load(std::memory_order_acquire)) - intptr_t(pos) );
+			if ( 0 == dif )
+			{
+				if ( m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) break;
+			}
+			else if ( dif < 0 ) return false;
+			else pos = m_push_pos.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::forward<_Value>(v);
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+}; //template class ConcurrentRingQueueTemplate
+
 };//namespace pw
 
 #endif//__PW_CONCURRENTQUEUE_H__
@@ -469,13 +469,13 @@ HttpClientChannel::_s_querySync ( http::query_param_type& param )
 {
 	auto& in(param.in);
 	auto& out(param.out);
-	const int64_t start(Timer::s_getNow());
+	const int64_t start(Timer::s_readNow());
 	errno = 0;
 
 	IoPoller* poller(IoPoller::s_create("auto"));
 	if ( nullptr == poller )
 	{
-		out.timeout = _set_leftTimeout(in.timeout, Timer::s_getNow() - start);
+		out.timeout = _set_leftTimeout(in.timeout, Timer::s_readNow() - start);
 		out.err = errno = ENOSYS;
 		return false;
 	}
@@ -487,7 +487,7 @@ HttpClientChannel::_s_querySync ( http::query_param_type& param )
 	do {
 		if ( nullptr == pch )
 		{
-			out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - start);
+			out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - start);
 			out.err = errno = ENOMEM;
 			break;
 		}
@@ -496,7 +496,7 @@ HttpClientChannel::_s_querySync ( http::query_param_type& param )
 
 		if ( not pch->query(in.host, *in.pk, out.pk) )
 		{
-			out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - start);
+			out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - start);
 			if ( 0 == errno ) param.out.err = errno = EPIPE;
 			else out.err = errno;
 			break;
@@ -504,7 +504,7 @@ HttpClientChannel::_s_querySync ( http::query_param_type& param )
 
 		do {
 			poller->dispatch(in.timeout);
-			if ( (Timer::s_getNow() - start) > in.timeout )
+			if ( (Timer::s_readNow() - start) > in.timeout )
 			{
 				out.err = errno = ETIMEDOUT;
 				pch->cancelQuery();
@@ -522,7 +522,7 @@ HttpClientChannel::_s_querySync ( http::query_param_type& param )
 
 		param.out.err = 0;
 		IoPoller::s_release(poller);
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - start);
 
 		param.in.poller = poller_old;
 		return true;
@@ -31,16 +31,19 @@
 #include "./pw_instance_if.h"
 #include "./pw_string.h"
 #include "./pw_iopoller_epoll.h"
+#include "./pw_iopoller_uring.h"
 #include "./pw_ssl.h"
 #include "./pw_crypto.h"
 #include "./pw_digest.h"
 #include "./pw_compress.h"
+#include "./pw_channel_if.h"
 
 #include <signal.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 namespace pw
 {
@@ -58,7 +61,21 @@ typedef struct _child_info_type
 typedef std::list<_child_info_type>	_child_info_cont;
 typedef _child_info_cont::iterator	_child_info_itr;
 
-static char s_header[1024] {0x00};
+static thread_local char s_header[1024] {0x00};
+
+//! \brief P2C 분배에 쓰는 난수. 암호용이 아니다.
+static
+uint64_t
+_random(void)
+{
+	static thread_local uint64_t s(0);
+	if ( 0 == s ) s = uint64_t(Timer::s_getWallNowMicro()) ^ (uint64_t(::getpid()) << 32) ^ uintptr_t(&s);
+	// xorshift64
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
 
 static
 void
@@ -96,6 +113,7 @@ _sigINT(int)
 }
 
 InstanceInterface* InstanceInterface::s_inst(nullptr);
+thread_local InstanceInterface::_Reactor* InstanceInterface::t_reactor(nullptr);
 
 InstanceInterface::_WakeUp::_WakeUp(InstanceInterface& inst) : m_inst(inst)
 {
@@ -106,6 +124,12 @@ InstanceInterface::_WakeUp::_WakeUp(InstanceInterface& inst) : m_inst(inst)
 }
 
 InstanceInterface::_WakeUp::~_WakeUp()
+{
+	close();
+}
+
+void
+InstanceInterface::_WakeUp::close(void)
 {
 	if ( -1 not_eq m_fd )
 	{
@@ -119,13 +143,7 @@ InstanceInterface::_WakeUp::~_WakeUp()
 void
 InstanceInterface::_WakeUp::reopen(void)
 {
-	if ( -1 not_eq m_fd )
-	{
-		IoPoller* poller( m_inst.getPoller() );
-		if ( poller ) poller->remove(m_fd);
-		::close(m_fd);
-		m_fd = -1;
-	}
+	close();
 	if ( -1 == ( m_fd = ::socket(PF_UNIX, SOCK_STREAM, 0)) )
 	{
 		PWLOGLIB("%s failed to initialize wakeup client", s_header);
@@ -169,6 +187,7 @@ InstanceInterface::InstanceInterface(const char* tag) : m_exit_code(EXIT_SUCCESS
 	m_poller.type = "auto";
 	m_poller.poller = nullptr;
 	m_poller.timeout = 500;
+	m_timer.precise = false;
 	m_flag.run = true;
 	m_flag.reload = false;
 	m_flag.stage = false;
@@ -179,6 +198,11 @@ InstanceInterface::InstanceInterface(const char* tag) : m_exit_code(EXIT_SUCCESS
 	m_child.dead_count = 0;
 	m_child.index = size_t(-1);
 	m_child.cont = nullptr;
+	m_child.reuseport = false;
+	m_child.reuseport_cpu = false;
+	m_child.dispatch = Dispatch::ROUND_ROBIN;
+	m_child.rr = size_t(-1);
+	m_child.load = nullptr;
 	s_inst = this;
 };
 
@@ -202,25 +226,27 @@ void InstanceInterface::logErrorV ( const char* file, size_t line, const char* f
 InstanceInterface::lsnr_type*
 InstanceInterface::getListenerInfo(const ListenerInterface* lsnr, const lsnr_type* e)
 {
-	auto ib(std::find_if_not(m_lsnrs.begin(), m_lsnrs.end(),
+	auto& lsnrs(getListeners());
+	auto ib(std::find_if_not(lsnrs.begin(), lsnrs.end(),
 	[e] (const lsnr_cont::value_type& v) { return &(v.second) == e; }
 							));
-	return (ib not_eq m_lsnrs.end() ? &(ib->second) : nullptr);
+	return (ib not_eq lsnrs.end() ? &(ib->second) : nullptr);
 }
 
 const InstanceInterface::lsnr_type*
 InstanceInterface::getListenerInfo(const ListenerInterface* lsnr, const lsnr_type* e) const
 {
-	auto ib(std::find_if_not(m_lsnrs.begin(), m_lsnrs.end(),
+	auto& lsnrs(getListeners());
+	auto ib(std::find_if_not(lsnrs.begin(), lsnrs.end(),
 	[e] (const lsnr_cont::value_type& v) { return &(v.second) == e; }
 							));
-	return (ib not_eq m_lsnrs.end() ? &(ib->second) : nullptr);
+	return (ib not_eq lsnrs.end() ? &(ib->second) : nullptr);
 }
 
 void
 InstanceInterface::setListenerEmpty(const ListenerInterface* lsnr)
 {
-	for(auto& info : m_lsnrs )
+	for(auto& info : getListeners() )
 	{
 		if ( lsnr == info.second.lsnr )
 		{
@@ -280,16 +306,17 @@ InstanceInterface::s_initSignals(void)
 int
 InstanceInterface::start(int argc, char* argv[])
 {
-	snprintf( s_header, sizeof(s_header), "[%d:%d]", static_cast<int>(getpid()), (isChild() ? static_cast<int>(m_child.index) : -1));
+	snprintf( s_header, sizeof(s_header), "[%d:%d]", static_cast<int>(getpid()), (isChild() ? static_cast<int>(getChildIndex()) : -1));
 	PWTRACE("%s STARTING", s_header);
 	m_args.count = argc;
 	m_args.value = argv;
+	// 리액터 스레드는 메인 스레드가 초기화한 라이브러리, 환경설정, 로그를 공유한다.
+	const bool reactor(isReactor());
 	PWTRACE("%s s_initLibraries", s_header);
-	if ( not s_initLibraries() )
+	if ( (not reactor) and (not s_initLibraries()) )
 	{
 		PWLOGLIB("%s failed to initialize libraries", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	if ( not isChild() )
 	{
@@ -297,15 +324,13 @@ InstanceInterface::start(int argc, char* argv[])
 		if ( not s_initSignals() )
 		{
 			PWLOGLIB("%s failed to initialize signals", s_header);
-			m_exit_code = EXIT_FAILURE;
-			return m_exit_code;
+			return _failStart();
 		}
 		PWTRACE("%s m_sysinfo.getAll()", s_header);
 		if ( not m_sysinfo.getAll() )
 		{
 			PWLOGLIB("%s failed to get system information", s_header);
-			m_exit_code = EXIT_FAILURE;
-			return m_exit_code;
+			return _failStart();
 		}
 	}
 	if ( argc >= 2 )
@@ -313,62 +338,72 @@ InstanceInterface::start(int argc, char* argv[])
 		m_config.path = argv[1];
 	}
 	PWTRACE("%s loadConfig", s_header);
-	if ( not loadConfig(m_config.path.c_str(), true, isChild()) )
+	if ( (not reactor) and (not loadConfig(m_config.path.c_str(), true, isChild())) )
 	{
 		PWLOGLIB("%s failed to load config: path:%s", s_header, m_config.path.c_str());
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	PWTRACE("%s eventInitLog", s_header);
-	if ( not eventInitLog() )
+	if ( (not reactor) and (not eventInitLog()) )
 	{
 		PWLOGLIB("%s failed to initialize log", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	Log::s_setLibrary(&m_log.err);
 	PWTRACE("%s createPoller", s_header);
-	if ( nullptr == (m_poller.poller = IoPoller::s_create(m_poller.type.c_str()) ) )
+	if ( nullptr == (_getPoller() = IoPoller::s_create(m_poller.type.c_str()) ) )
 	{
 		PWLOGLIB("%s failed to initialize poller: type:%s", s_header, m_poller.type.c_str());
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	else
 	{
-		PWLOGLIB("%s success to initialize poller: type:%s", s_header, m_poller.poller->getType());
+		PWLOGLIB("%s success to initialize poller: type:%s", s_header, getPoller()->getType());
+	}
+	if ( m_timer.precise and (not Timer::s_getInstance().setPoller(getPoller())) )
+	{
+		PWLOGLIB("%s failed to set precise timer, use default timer", s_header);
+	}
+	if ( not getJobManager().setIoPoller(getPoller()) )
+	{
+		PWLOGLIB("%s failed to set job manager notifier, reserved jobs are dispatched by loop", s_header);
+	}
+	if ( reactor and (not t_reactor->notifier.open(getPoller())) )
+	{
+		PWLOGLIB("%s failed to open reactor notifier, stop is checked by loop", s_header);
 	}
+	_WakeUp& wakeup(reactor ? t_reactor->wakeup : m_wakeup);
 	PWTRACE("%s add wakeup", s_header);
-	if ( not m_poller.poller->add(m_wakeup.m_fd, &m_wakeup, POLLOUT) )
+	if ( not getPoller()->add(wakeup.m_fd, &wakeup, POLLOUT) )
 	{
 		PWLOGLIB("%s failed to add wakeup instance", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
+	// 리액터 스레드마다 같은 인스턴스의 초기화 함수를 부르므로 한 번에 하나씩 부른다.
+	// 메인 스레드는 리액터를 띄운 뒤부터 잠근다. fork 전에 잠그면 차일드가 잠긴 채로 시작한다.
+	std::unique_lock<std::mutex> hook_lock(m_hook_lock, std::defer_lock);
+	if ( reactor ) hook_lock.lock();
 	PWTRACE("%s eventInitChannel", s_header);
 	if ( not eventInitChannel() )
 	{
 		PWLOGLIB("%s failed to initialize channels", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	PWTRACE("%s eventInitListener", s_header);
 	if ( not eventInitListener() )
 	{
 		PWLOGLIB("%s failed to initialize listener", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	if ( (m_child.count > 0)
-			and (ProcessType::MULTI == m_child.type)
-			and (size_t(-1) == m_child.index) )
+			and ( (ProcessType::MULTI == m_child.type) or (ProcessType::THREAD == m_child.type) )
+			and (not isChild()) )
 	{
 		PWTRACE("%s eventInitChild", s_header);
 		if ( not eventInitChild() )
 		{
 			PWLOGLIB("%s failed to initialize child: count:%zu", s_header, m_child.count);
-			m_exit_code = EXIT_FAILURE;
-			return m_exit_code;
+			return _failStart();
 		}
 		if ( isChild() )
 		{
@@ -376,48 +411,71 @@ InstanceInterface::start(int argc, char* argv[])
 			::exit(res);
 		}
 	}
+	if ( (not reactor) and (ProcessType::THREAD == m_child.type) ) hook_lock.lock();
 	PWTRACE("%s eventInitTimer", s_header);
 	if ( not eventInitTimer() )
 	{
 		PWLOGLIB("%s failed to initialize timer", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
 	PWTRACE("%s eventInitExtras", s_header);
 	if ( not eventInitExtras() )
 	{
 		PWLOGLIB("%s failed to initialize extras", s_header);
-		m_exit_code = EXIT_FAILURE;
-		return m_exit_code;
+		return _failStart();
 	}
-	bool& run(m_flag.run);
-	bool& check_child(m_flag.check_child);
+	if ( hook_lock.owns_lock() ) hook_lock.unlock();
+	std::atomic<bool>& run(m_flag.run);
+	std::atomic<bool>& check_child(m_flag.check_child);
 	bool& reload(m_flag.reload);
-	IoPoller& poller(*m_poller.poller);
+	IoPoller& poller(*getPoller());
+	JobManager& job(getJobManager());
+	const std::atomic<bool>* stop(reactor ? &(t_reactor->stop) : nullptr);
+	child_load_type* load( (isChild() and m_child.load) ? m_child.load + getChildIndex() : nullptr );
+	// 폴러가 기다림에서 돌아온 시각을 남겨 부모가 멈춘 차일드를 알아챌 수 있게 한다.
+	if ( load ) poller.setBusyMarker(&(load->busy));
 	PWTRACE("%s start loop", s_header);
-	while ( run )
+	Timer::s_refresh();
+	while ( run and ( (nullptr == stop) or (not *stop) ) )
 	{
-		if ( check_child )
+		// 차일드 검사와 환경설정 다시 읽기는 메인 스레드에서만 한다.
+		if ( check_child and (not reactor) )
 		{
 			PWTRACE("check dead child...");
 			check_child = false;
 			_checkChild();
 		}
-		if ( reload )
+		if ( reload and (not reactor) )
 		{
 			PWTRACE("%s reload config...", s_header);
 			reload = false;
-			loadConfig(nullptr, true, true);
+			if ( (ProcessType::THREAD == m_child.type) and (m_child.count > 0) )
+			{
+				// 리액터 스레드가 읽고 있는 설정을 바꿀 수 없다.
+				PWLOGLIB("%s config reload is not supported in thread mode", s_header);
+			}
+			else loadConfig(nullptr, true, true);
 		}
 		if ( poller.dispatch(m_poller.timeout) < 0 )
 		{
 			PWLOGLIB("%s poller error: errno:%d %s", s_header, errno, strerror(errno));
 			// do nothing...
 		}
-		m_job.man.checkTimeout(m_timeout.job);
+		// 시간은 루프마다 한 번 갱신하고, 이번 턴의 처리는 모두 이 값을 쓴다.
+		Timer::s_refresh();
+		job.checkTimeout(m_timeout.job);
 		Timer::s_getInstance().check();
 		eventEndTurn();
+		if ( load ) load->conn.store(uint32_t(ChannelInterface::s_getLocalCount()), std::memory_order_relaxed);
+	}
+	if ( reactor )
+	{
+		std::lock_guard<std::mutex> exit_lock(m_hook_lock);
+		eventExit();
+		return EXIT_SUCCESS;
 	}
+	// 메인 스레드가 정리하기 전에 리액터 스레드를 모두 멈춘다.
+	_joinReactors();
 	eventExit();
 	return m_exit_code;
 }
@@ -443,6 +501,7 @@ InstanceInterface::_checkChild(void)
 			ci->pid = -1;
 			ci->param = nullptr;
 			_closePair(ci->fd);
+			_closeReusePort(ci->index);
 			break;
 		}
 		else
@@ -451,6 +510,18 @@ InstanceInterface::_checkChild(void)
 		}
 	}
 	while (true);
+	for ( auto& reactor : m_reactors )
+	{
+		if ( not (reactor and reactor->done) ) continue;
+		reactor->thread.join();
+		child_type& child(m_child.cont[reactor->index]);
+		cont.push_back(_child_info_type(reactor->index, child.pid, reactor->exit_code, child.param));
+		child.pid = -1;
+		child.param = nullptr;
+		_closePair(child.fd);
+		_closeReusePort(reactor->index);
+		reactor.reset();
+	}
 	_child_info_itr ib(cont.begin());
 	_child_info_itr ie(cont.end());
 	while ( ib != ie )
@@ -549,14 +620,29 @@ InstanceInterface::loadDefaultConfig(bool isReload)
 		{
 			std::string tmp("single");
 			tmp = conf.getString2(tmp, "child.type", sec, tmp);
-			m_child.type = ( 0 == strcasecmp(tmp.c_str(), "multi") ) ? ProcessType::MULTI : ProcessType::SINGLE;
+			if ( 0 == strcasecmp(tmp.c_str(), "multi") ) m_child.type = ProcessType::MULTI;
+			else if ( 0 == strcasecmp(tmp.c_str(), "thread") ) m_child.type = ProcessType::THREAD;
+			else m_child.type = ProcessType::SINGLE;
 		}
 		while(false);
 		m_child.count = conf.getInteger("child.count", sec, m_child.count);
 		if ( m_child.count == 0 ) m_child.type = ProcessType::SINGLE;
 		if ( m_child.type == ProcessType::SINGLE ) m_child.count = 0;
-		PWTRACE("child.type: %s", m_child.type == ProcessType::MULTI ? "multi" : "single");
+		PWTRACE("child.type: %s", m_child.type == ProcessType::MULTI ? "multi" : ( m_child.type == ProcessType::THREAD ? "thread" : "single" ));
 		PWTRACE("child.count: %zu", m_child.count);
+		m_child.reuseport = conf.getBoolean("child.reuseport", sec, m_child.reuseport) and (not isSingle());
+		m_child.reuseport_cpu = conf.getBoolean("child.reuseport.cpu", sec, m_child.reuseport_cpu);
+		PWTRACE("child.reuseport: %d cpu:%d", int(m_child.reuseport), int(m_child.reuseport_cpu));
+		do
+		{
+			std::string tmp("rr");
+			tmp = conf.getString2(tmp, "child.dispatch", sec, tmp);
+			if ( 0 == strcasecmp(tmp.c_str(), "least") ) m_child.dispatch = Dispatch::LEAST;
+			else if ( 0 == strcasecmp(tmp.c_str(), "p2c") ) m_child.dispatch = Dispatch::P2C;
+			else m_child.dispatch = Dispatch::ROUND_ROBIN;
+			PWTRACE("child.dispatch: %s", tmp.c_str());
+		}
+		while(false);
 		if ( not isSingle() )
 		{
 			if ( not _initChildInfo() )
@@ -580,6 +666,56 @@ InstanceInterface::loadDefaultConfig(bool isReload)
 		return false;
 	}
 	PWTRACE("poller.timeout: %jd", intmax_t(m_poller.timeout));
+	do
+	{
+		const intmax_t limit(conf.getInteger("iobuffer.pool.limit", sec, intmax_t(IoBufferPool::s_getLimit())));
+		IoBufferPool::s_setLimit( limit > 0 ? size_t(limit) : 0 );
+		PWTRACE("iobuffer.pool.limit: %zu", IoBufferPool::s_getLimit());
+	} while (false);
+	do
+	{
+		const intmax_t budget(conf.getInteger("accept.budget", sec, intmax_t(ListenerInterface::s_getAcceptBudget())));
+		ListenerInterface::s_setAcceptBudget( budget > 0 ? size_t(budget) : 1 );
+		PWTRACE("accept.budget: %zu", ListenerInterface::s_getAcceptBudget());
+	} while (false);
+	do
+	{
+		const intmax_t budget(conf.getInteger("read.budget", sec, intmax_t(ChannelInterface::s_getReadBudget())));
+		ChannelInterface::s_setReadBudget( budget > 0 ? size_t(budget) : 1 );
+		PWTRACE("read.budget: %zu", ChannelInterface::s_getReadBudget());
+	} while (false);
+	do
+	{
+		std::string tmp;
+		conf.getString2(tmp, "timer.clock", sec);
+		if ( tmp.empty() ) break;
+
+		Timer::Clock clock(Timer::s_getClock());
+		if ( 0 == strcasecmp(tmp.c_str(), "monotonic") ) clock = Timer::Clock::MONOTONIC;
+		else if ( 0 == strcasecmp(tmp.c_str(), "coarse") ) clock = Timer::Clock::MONOTONIC_COARSE;
+		else if ( 0 == strcasecmp(tmp.c_str(), "realtime") ) clock = Timer::Clock::REALTIME;
+		else
+		{
+			PWLOGLIB("invalid timer.clock: %s", tmp.c_str());
+			break;
+		}
+
+		PWTRACE("timer.clock: %s", tmp.c_str());
+		Timer::s_setClock(clock);
+	} while (false);
+	Timer::s_setCache(conf.getBoolean("timer.cache", sec, Timer::s_isCache()));
+	do
+	{
+		const bool precise(conf.getBoolean("timer.precise", sec, m_timer.precise));
+		PWTRACE("timer.precise: %d", int(precise));
+		if ( precise == m_timer.precise ) break;
+
+		m_timer.precise = precise;
+		if ( m_poller.poller and (not Timer::s_getInstance().setPoller(precise ? m_poller.poller : nullptr)) )
+		{
+			PWLOGLIB("failed to set precise timer, use default timer");
+		}
+	} while (false);
 	bool use_trace(Log::s_getTrace());
 	Log::s_setTrace(conf.getBoolean("log.trace", sec, use_trace));
 	return true;
@@ -601,9 +737,85 @@ InstanceInterface::_initChildInfo(void)
 		ci.param = nullptr;
 		ci.fd[0] = ci.fd[1] = -1;
 	}
+	if ( ProcessType::THREAD == m_child.type ) m_reactors.resize(m_child.count);
+	// fork 전에 만들어 두어 차일드와 공유한다.
+	void* load(::mmap(nullptr, sizeof(child_load_type) * m_child.count, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_ANONYMOUS, -1, 0));
+	if ( MAP_FAILED == load )
+	{
+		PWLOGLIB("failed to map child load table(%d): %s, use round robin", errno, strerror(errno));
+		return true;
+	}
+	m_child.load = static_cast<child_load_type*>(load);
+	for ( size_t i(0); i < m_child.count; i++ ) new (&m_child.load[i]) child_load_type();
 	return true;
 }
 
+size_t
+InstanceInterface::selectChild(void)
+{
+	const size_t count(m_child.count);
+	if ( (0 == count) or (nullptr == m_child.cont) ) return size_t(-1);
+
+	auto alive = [this] (size_t i) { return -1 not_eq m_child.cont[i].getFDByParent(); };
+	size_t index(size_t(-1));
+	if ( (nullptr == m_child.load) or (Dispatch::ROUND_ROBIN == m_child.dispatch) )
+	{
+		for ( size_t i(0); i < count; i++ )
+		{
+			m_child.rr = (m_child.rr + 1) % count;
+			if ( alive(m_child.rr) ) { index = m_child.rr; break; }
+		}
+	}
+	else if ( (Dispatch::LEAST == m_child.dispatch) or (count < 3) )
+	{
+		const int64_t now(Timer::s_getNowMicro());
+		int64_t min(INT64_MAX);
+		// 같은 점수면 라운드 로빈처럼 돌아가며 고른다.
+		m_child.rr = (m_child.rr + 1) % count;
+		for ( size_t n(0); n < count; n++ )
+		{
+			const size_t i((m_child.rr + n) % count);
+			if ( not alive(i) ) continue;
+			const int64_t score(getChildScore(i, now));
+			if ( score < min ) { min = score; index = i; }
+		}
+	}
+	else
+	{
+		const int64_t now(Timer::s_getNowMicro());
+		const uint64_t r(_random());
+		const size_t a(r % count);
+		size_t b((r >> 32) % (count - 1));
+		if ( b >= a ) ++b;
+		if ( not alive(a) ) index = alive(b) ? b : size_t(-1);
+		else if ( not alive(b) ) index = a;
+		else index = ( getChildScore(b, now) < getChildScore(a, now) ) ? b : a;
+	}
+
+	if ( m_child.load and (size_t(-1) not_eq index) ) m_child.load[index].pending.fetch_add(1, std::memory_order_relaxed);
+	return index;
+}
+
+void
+InstanceInterface::releaseChild(size_t index)
+{
+	if ( (nullptr == m_child.load) or (index >= m_child.count) ) return;
+	std::atomic<uint32_t>& pending(m_child.load[index].pending);
+	uint32_t v(pending.load(std::memory_order_relaxed));
+	while ( (v > 0) and (not pending.compare_exchange_weak(v, v - 1, std::memory_order_relaxed)) ) {}
+}
+
+int64_t
+InstanceInterface::getChildScore(size_t index, int64_t now) const
+{
+	const child_load_type* load(getChildLoad(index));
+	if ( nullptr == load ) return 0;
+	const int64_t busy(load->busy.load(std::memory_order_relaxed));
+	// 한 턴을 오래 잡고 있는 차일드는 처리 중인 시간만큼 무겁게 본다.
+	const int64_t lag( ((busy > 0) and (now > busy)) ? (now - busy) / 1000 : 0 );
+	return int64_t(load->conn.load(std::memory_order_relaxed)) + int64_t(load->pending.load(std::memory_order_relaxed)) + lag;
+}
+
 char*
 InstanceInterface::makeLogPrefix(char* obuf, size_t obuflen, const char* typetag) const
 {
@@ -701,12 +913,35 @@ InstanceInterface::fork(size_t index, void* param)
 		return false;
 	}
 	child_type& child(m_child.cont[index]);
+	if ( (ProcessType::THREAD == m_child.type) and m_reactors[index] )
+	{
+		PWLOGLIB("%s reactor is still running: index:%zu", s_header, index);
+		return false;
+	}
 	_closePair(child.fd);
 	if ( -1 == ::socketpair(PF_LOCAL, SOCK_STREAM, 0, child.fd) )
 	{
 		PWLOGLIB("%s failed to initialize pair socket(%d): %s", s_header, errno, strerror(errno));
 		return false;
 	}
+	if ( m_child.load )
+	{
+		child_load_type& load(m_child.load[index]);
+		load.conn = 0;
+		load.pending = 0;
+		load.busy = 0;
+	}
+	if ( not _reopenReusePort(index) )
+	{
+		_closePair(child.fd);
+		return false;
+	}
+	if ( ProcessType::THREAD == m_child.type )
+	{
+		if ( _startReactor(index, param) ) return true;
+		_closePair(child.fd);
+		return false;
+	}
 	pid_t pid(::fork());
 	if ( pid == -1 )
 	{
@@ -726,6 +961,7 @@ InstanceInterface::fork(size_t index, void* param)
 			ci.pid = -1;
 			ci.param = nullptr;
 			_closePair(ci.fd);
+			_closeReusePort(i);
 		}
 		struct _start& start(const_cast<struct _start&>(m_start));
 		start.child = time(nullptr);
@@ -744,10 +980,170 @@ InstanceInterface::fork(size_t index, void* param)
 	return true;
 }
 
+bool
+InstanceInterface::_openListenerReusePort(const std::string& name, int type)
+{
+	auto& ctx(m_lsnrs[name]);
+	for ( auto fd : ctx.reuseport ) if ( -1 not_eq fd ) ::close(fd);
+	ctx.reuseport.clear();
+	ctx.type = type;
+
+	// 부모가 차일드 순서대로 만들어 두어야 그룹 안의 순서가 차일드 인덱스와 같다.
+	// 차일드가 죽으면 _closeReusePort()로 닫고, 다시 뜰 때 _reopenReusePort()로 새로 연다.
+	SocketAddress sa;
+	sa.setIP4("0", ctx.port.c_str());
+	for ( size_t i(0); i < m_child.count; i++ )
+	{
+		const int fd(ListenerInterface::s_listen(sa, SOCK_STREAM, 0, true));
+		if ( -1 == fd )
+		{
+			logError(__FILE__, __LINE__, "failed to open reuseport listener: type:%d name:%s port:%s index:%zu", type, name.c_str(), ctx.port.c_str(), i);
+			for ( auto lfd : ctx.reuseport ) if ( -1 not_eq lfd ) ::close(lfd);
+			ctx.reuseport.clear();
+			return false;
+		}
+		ctx.reuseport.push_back(fd);
+	}
+
+	if ( m_child.reuseport_cpu and (not ListenerInterface::s_attachReusePortCPU(ctx.reuseport.front(), m_child.count)) )
+	{
+		PWLOGLIB("%s failed to set cpu steering, use kernel hash: name:%s", s_header, name.c_str());
+	}
+
+	return true;
+}
+
+void
+InstanceInterface::_closeReusePort(size_t index)
+{
+	// 죽은 차일드의 소켓이 그룹에 남으면 커널이 그 소켓으로 보낸 접속은 다시 뜰 때까지 기다린다.
+	for ( auto& ctx : m_lsnrs )
+	{
+		auto& cont(ctx.second.reuseport);
+		if ( (index >= cont.size()) or (-1 == cont[index]) ) continue;
+		::close(cont[index]);
+		cont[index] = -1;
+	}
+}
+
+bool
+InstanceInterface::_reopenReusePort(size_t index)
+{
+	for ( auto& ctx : m_lsnrs )
+	{
+		auto& cont(ctx.second.reuseport);
+		if ( (index >= cont.size()) or (-1 not_eq cont[index]) ) continue;
+
+		SocketAddress sa;
+		sa.setIP4("0", ctx.second.port.c_str());
+		if ( -1 == (cont[index] = ListenerInterface::s_listen(sa, SOCK_STREAM, 0, true)) )
+		{
+			PWLOGLIB("%s failed to reopen reuseport listener: name:%s port:%s index:%zu", s_header, ctx.first.c_str(), ctx.second.port.c_str(), index);
+			return false;
+		}
+	}
+	return true;
+}
+
+int
+InstanceInterface::_dupListenerReusePort(const std::string& name, int& type) const
+{
+	// 리액터 스레드도 읽으므로 operator[]를 쓰지 않는다.
+	auto ib(m_lsnrs.find(name));
+	const size_t index(getChildIndex());
+	if ( (m_lsnrs.end() == ib) or (index >= ib->second.reuseport.size()) ) return -1;
+
+	type = ib->second.type;
+	const int fd(::fcntl(ib->second.reuseport[index], F_DUPFD_CLOEXEC, 0));
+	if ( -1 == fd )
+	{
+		PWLOGLIB("%s failed to dup reuseport listener(%d): name:%s %s", s_header, errno, name.c_str(), strerror(errno));
+	}
+	return fd;
+}
+
+bool
+InstanceInterface::_startReactor(size_t index, void* param)
+{
+	child_type& child(m_child.cont[index]);
+	std::unique_ptr<_Reactor> reactor(new _Reactor(*this, index));
+	// 포트만 가져가고 리스너는 리액터 스레드가 연다.
+	for ( auto& ctx : m_lsnrs ) reactor->lsnrs[ctx.first].port = ctx.second.port;
+	child.pid = ::getpid();
+	child.param = param;
+	m_reactors[index] = std::move(reactor);
+	try
+	{
+		m_reactors[index]->thread = std::thread(&InstanceInterface::_runReactor, this, index);
+	}
+	catch (const std::system_error& e)
+	{
+		PWLOGLIB("%s failed to start reactor thread: index:%zu %s", s_header, index, e.what());
+		m_reactors[index].reset();
+		child.pid = -1;
+		child.param = nullptr;
+		return false;
+	}
+	PWLOGLIB("success to start reactor thread: index:%zu", index);
+	return true;
+}
+
+void
+InstanceInterface::_runReactor(size_t index)
+{
+	_Reactor& reactor(*m_reactors[index]);
+	t_reactor = &reactor;
+	reactor.exit_code = start(m_args.count, m_args.value);
+
+	// 스레드가 만든 자원은 스레드 안에서 정리한다.
+	reactor.notifier.close(true);
+	reactor.job.setIoPoller(nullptr);
+	reactor.wakeup.close();
+	for ( auto& ctx : reactor.lsnrs )
+	{
+		ListenerInterface* lsnr(ctx.second.lsnr);
+		if ( nullptr == lsnr ) continue;
+		lsnr->close();
+		delete lsnr;
+		setListenerEmpty(lsnr);
+	}
+	Timer::s_getInstance().clear();
+	if ( reactor.poller )
+	{
+		IoPoller::s_release(reactor.poller);
+		reactor.poller = nullptr;
+	}
+	PWLOGLIB("reactor thread is done: index:%zu exit_code:%d", index, reactor.exit_code);
+	t_reactor = nullptr;
+	reactor.done = true;
+	setFlagCheckChild();
+}
+
+void
+InstanceInterface::_joinReactors(void)
+{
+	for ( auto& reactor : m_reactors )
+	{
+		if ( not reactor ) continue;
+		reactor->stop = true;
+		reactor->notifier.notify();
+	}
+	for ( auto& reactor : m_reactors )
+	{
+		if ( not reactor ) continue;
+		reactor->thread.join();
+		child_type& child(m_child.cont[reactor->index]);
+		child.pid = -1;
+		child.param = nullptr;
+		_closePair(child.fd);
+		reactor.reset();
+	}
+}
+
 bool
 InstanceInterface::wakeUp(void)
 {
-	return m_wakeup.setEventOut();
+	return ( t_reactor ? t_reactor->wakeup : m_wakeup ).setEventOut();
 }
 
 void
@@ -756,8 +1152,13 @@ InstanceInterface::cleanUpForChild(size_t index, void* param)
 #if defined(HAVE_EPOLL)
 	IoPoller_Epoll* poller(dynamic_cast<IoPoller_Epoll*>(m_poller.poller));
 	if ( poller ) poller->destroy();
+#endif
+#if defined(HAVE_IO_URING)
+	IoPoller_Uring* uring(dynamic_cast<IoPoller_Uring*>(m_poller.poller));
+	if ( uring ) uring->destroy();
 #endif
 	m_wakeup.reopen();
+	m_job.man.clearIoPoller();
 	eventForkCleanUpChannel(index, param);
 	eventForkCleanUpListener(index, param);
 	eventForkCleanUpExtras(index, param);
@@ -848,6 +1249,19 @@ InstanceInterface::signalToChild(int signal, size_t idx) const
 	if ( isChild() ) return false;
 	auto child(getChildByIndex(idx));
 	if ( nullptr == child ) return false;
+	if ( ProcessType::THREAD == m_child.type )
+	{
+		if ( not m_reactors[idx] ) return false;
+		switch(signal)
+		{
+		case SIGINT: case SIGTERM: case SIGUSR1: case SIGUSR2: case SIGKILL: break;
+		default: return false;
+		}
+		// 아직 알림을 열지 않았으면 루프에 들어가며 확인한다.
+		m_reactors[idx]->stop = true;
+		m_reactors[idx]->notifier.notify();
+		return true;
+	}
 	return 0 == ::kill(child->pid, signal);
 }
 
@@ -34,9 +34,14 @@
 #include "./pw_iopoller.h"
 #include "./pw_listener_if.h"
 #include "./pw_jobmanager.h"
+#include "./pw_notifier.h"
 #include "./pw_sysinfo.h"
 #include "./pw_log.h"
 
+#include <thread>
+#include <atomic>
+#include <mutex>
+
 #ifndef __PW_INSTANCE_H__
 #define __PW_INSTANCE_H__
 
@@ -60,7 +65,25 @@ public:
 	enum class ProcessType
 	{
 		SINGLE,	//!< 싱글
-		MULTI	//!< 멀티
+		MULTI,	//!< 멀티
+		THREAD	//!< 멀티 스레드. 한 프로세스 안에서 스레드마다 리액터를 돌린다.
+	};
+
+	//! \brief 부모 리스너가 접속을 넘길 차일드를 고르는 방식
+	enum class Dispatch
+	{
+		ROUND_ROBIN,	//!< 차례대로
+		LEAST,	//!< 부하가 가장 적은 차일드
+		P2C,	//!< 임의의 두 차일드 중 부하가 적은 차일드 (power of two choices)
+	};
+
+	//! \brief 차일드 부하.
+	//! \details 공유 메모리에 두어 부모와 차일드(프로세스나 스레드)가 함께 본다.
+	struct alignas(64) child_load_type final
+	{
+		std::atomic<uint32_t>	conn{0};	//!< 차일드의 채널 개수. 차일드가 루프마다 쓴다.
+		std::atomic<uint32_t>	pending{0};	//!< 부모가 넘겼지만 차일드가 아직 받지 않은 접속 개수
+		std::atomic<int64_t>	busy{0};	//!< 이벤트를 처리하기 시작한 시각(us). 폴러에서 기다리는 중이면 0이다.
 	};
 
 	//! \brief 차일드 프로세스 정보
@@ -82,6 +105,8 @@ public:
 	{
 		std::string port;
 		ListenerInterface* lsnr { nullptr };
+		int type { ListenerInterface::LT_NONE };	//!< SO_REUSEPORT 모드의 리스너 타입
+		std::vector<int> reuseport;	//!< SO_REUSEPORT 리슨 소켓. 차일드 인덱스 순서이다.
 	};
 
 	using lsnr_cont = std::map<std::string, lsnr_type>;
@@ -122,13 +147,18 @@ public:
 	char* makeLogPrefix(char* obuf, size_t obuflen, const char* typetag) const;
 	std::string& makeLogPrefix(std::string& obuf, const std::string& typetag) const;
 
+	//! \brief 현재 스레드의 리스너 컨테이너
+	//! \details 스레드 모드의 리액터 스레드에서는 스레드마다 따로 가진다.
+	inline lsnr_cont& getListeners(void) { return t_reactor ? t_reactor->lsnrs : m_lsnrs; }
+	inline const lsnr_cont& getListeners(void) const { return t_reactor ? t_reactor->lsnrs : m_lsnrs; }
+
 	//! \brief 리스너 객체 가져오기
-	inline const ListenerInterface* getListener(const std::string& name) const { auto ib(m_lsnrs.find(name)); return (ib not_eq m_lsnrs.end() ? ib->second.lsnr : nullptr); }
-	inline ListenerInterface* getListener(const std::string& name) { auto ib(m_lsnrs.find(name)); return (ib not_eq m_lsnrs.end() ? ib->second.lsnr : nullptr); }
+	inline const ListenerInterface* getListener(const std::string& name) const { auto& lsnrs(getListeners()); auto ib(lsnrs.find(name)); return (ib not_eq lsnrs.end() ? ib->second.lsnr : nullptr); }
+	inline ListenerInterface* getListener(const std::string& name) { auto& lsnrs(getListeners()); auto ib(lsnrs.find(name)); return (ib not_eq lsnrs.end() ? ib->second.lsnr : nullptr); }
 
 	//! \brief 리스너 정보 객체 가져오기
 	//inline const lsnr_type& getListenerInfo(const std::string& name) const { return m_lsnrs[name]; }
-	inline lsnr_type& getListenerInfo(const std::string& name) { return m_lsnrs[name]; }
+	inline lsnr_type& getListenerInfo(const std::string& name) { return getListeners()[name]; }
 	lsnr_type* getListenerInfo(const ListenerInterface* lsnr, const lsnr_type* e = nullptr);
 	const lsnr_type* getListenerInfo(const ListenerInterface* lsnr, const lsnr_type* e = nullptr) const;
 
@@ -139,21 +169,28 @@ public:
 	void setListenerEmpty(const ListenerInterface* lsnr);
 
 	//! \brief Fork
+	//! \details 스레드 모드에서는 프로세스 대신 리액터 스레드를 시작한다.
 	bool fork(size_t index, void* param);
 
 	//! \brief 폴러를 강제로 반환.
+	//! \details 다른 스레드에서 일을 넘기려면 PollerQueueTemplate을 폴러에 등록하는 것이 좋다.
 	bool wakeUp(void);
 
 	//! \brief 차일드 프로세스인지 확인
-	inline bool isChild(void) const { return m_child.index not_eq size_t(-1); }
+	//! \details 스레드 모드의 리액터 스레드도 차일드로 본다.
+	inline bool isChild(void) const { return getChildIndex() not_eq size_t(-1); }
+
+	//! \brief 스레드 모드의 리액터 스레드인지 확인
+	inline bool isReactor(void) const { return nullptr not_eq t_reactor; }
 
 	//! \brief 차일드 인덱스 가져오기
-	inline size_t getChildIndex(void) const { return m_child.index; }
+	inline size_t getChildIndex(void) const { return t_reactor ? t_reactor->index : m_child.index; }
 
 	//! \brief 차일드 개수 가져오기
 	inline size_t getChildCount(void) const { return m_child.count; }
 
 	//! \brief 차일드에게 시그널 보내기
+	//! \details 스레드 모드에서는 종료 시그널(SIGINT, SIGTERM, SIGUSR1, SIGUSR2, SIGKILL)만 리액터 정지로 바꾸어 전달한다.
 	//! \warning 호출한 쪽이 차일드이거나, 차일드가 없는 환경이면 무시한다.
 	bool signalToChild(int signal, size_t idx) const;
 
@@ -181,6 +218,7 @@ public:
 	bool openListenerSingle(const std::string& name);
 
 	//! \brief 멀티 모드 부모 리스너 열기 템플릿 함수
+	//! \details SO_REUSEPORT 모드에서는 접속을 받지 않고 차일드마다 리슨 소켓만 만들어 둔다.
 	template<int _ListenerType>
 	bool openListenerParent(const std::string& name);
 
@@ -201,6 +239,31 @@ public:
 	//! \brief 프로세스 타입 확인
 	inline ProcessType getProcessType(void) const { return m_child.type; }
 
+	//! \brief 차일드가 SO_REUSEPORT 소켓으로 직접 접속을 받는지 확인
+	inline bool isReusePort(void) const { return m_child.reuseport; }
+
+	//! \brief 차일드 분배 방식
+	inline Dispatch getDispatch(void) const { return m_child.dispatch; }
+
+	//! \brief 분배 방식에 따라 접속을 넘길 차일드를 고르고, 대기 접속 개수를 늘린다.
+	//! \return 넘길 차일드가 없으면 size_t(-1)을 반환한다.
+	size_t selectChild(void);
+
+	//! \brief 대기 접속 개수를 줄인다.
+	//! \details 차일드가 접속을 받았거나, 부모가 넘기지 못했을 때 호출한다.
+	void releaseChild(size_t index);
+
+	//! \brief 차일드 부하
+	//! \return 부하 테이블이 없으면 nullptr을 반환한다.
+	inline const child_load_type* getChildLoad(size_t index) const
+	{
+		return ( (nullptr == m_child.load) or (index >= m_child.count) ) ? nullptr : &(m_child.load[index]);
+	}
+
+	//! \brief 차일드 부하 점수. 채널 개수, 대기 접속 개수, 처리 중인 시간(ms)을 더한다.
+	//! \param[in] now 현재 시각(us)
+	int64_t getChildScore(size_t index, int64_t now) const;
+
 	//! \brief 인덱스로 차일드 PID
 	//! \return 실패하면 pid_t(-1)을 반환한다.
 	inline pid_t getChildPID(size_t index) const
@@ -263,14 +326,16 @@ public:
 	//! \return 실패하면 nullptr을 반환한다.
 	inline child_type* getChildSelf(void)
 	{
-		return ( size_t(-1) == m_child.index ) ? nullptr : &(m_child.cont[m_child.index]);
+		const size_t index(getChildIndex());
+		return ( size_t(-1) == index ) ? nullptr : &(m_child.cont[index]);
 	}
 
 	//! \brief 차일드 자신의 객체
 	//! \return 실패하면 nullptr을 반환한다.
 	const child_type* getChildSelf(void) const
 	{
-		return ( size_t(-1) == m_child.index ) ? nullptr : &(m_child.cont[m_child.index]);
+		const size_t index(getChildIndex());
+		return ( size_t(-1) == index ) ? nullptr : &(m_child.cont[index]);
 	}
 
 	//! \brief 환경설정 객체
@@ -300,6 +365,10 @@ protected:
 	inline virtual bool eventInitLog(void) { return true; }
 
 	//! \brief (서비스)채널 초기화
+	//! \details 스레드 모드에서는 eventInitChannel, eventInitListener, eventInitTimer, eventInitExtras, eventExit가
+	//!	리액터 스레드마다 한 번씩 불린다. 이 함수들은 한 번에 하나씩만 불리므로 안에서 멤버를 고쳐도 되며,
+	//!	getChildIndex()로 리액터 인덱스를 알 수 있다. eventInitLog, eventConfig, eventInitChild는 메인 스레드에서 한 번만 불린다.
+	//!	eventEndTurn과 채널 이벤트는 리액터마다 동시에 불리므로 공유하는 멤버는 직접 보호해야 한다.
 	inline virtual bool eventInitChannel(void) { return true; }
 
 	//! \brief 리스너 초기화
@@ -329,6 +398,7 @@ protected:
 	virtual void eventExitChild(size_t index, pid_t pid, int exit_status, void* param);
 
 	//! \brief 매 poller 턴이 끝날 때마다 호출함
+	//! \details 스레드 모드에서는 리액터 스레드마다 동시에 부른다.
 	inline virtual void eventEndTurn(void) {};
 
 	//! \brief fork한 뒤, 차일드에서 호출함
@@ -405,14 +475,22 @@ public:
 	//! \brief 폴러 타입.
 	inline const char* getPollerType(void) const { return m_poller.type.c_str(); }
 
-	//! \brief 폴러 객체.
-	inline IoPoller* getPoller(void) { return m_poller.poller; }
+	//! \brief 현재 스레드의 폴러 객체.
+	inline IoPoller* getPoller(void) { return t_reactor ? t_reactor->poller : m_poller.poller; }
 
-	//! \brief 폴러 객체.
-	inline const IoPoller* getPoller(void) const { return m_poller.poller; }
+	//! \brief 현재 스레드의 폴러 객체.
+	inline const IoPoller* getPoller(void) const { return t_reactor ? t_reactor->poller : m_poller.poller; }
+
+	//! \brief 현재 스레드의 잡 매니저.
+	//! \details 스레드 모드의 리액터 스레드에서는 스레드마다 따로 가진다.
+	inline JobManager& getJobManager(void) { return t_reactor ? t_reactor->job : m_job.man; }
+	inline const JobManager& getJobManager(void) const { return t_reactor ? t_reactor->job : m_job.man; }
 
 	inline int64_t getPollerTimeout(void) const { return m_poller.timeout; }
 
+	//! \brief 타이머 정밀 모드 설정 여부.
+	inline bool isTimerPrecise(void) const { return m_timer.precise; }
+
 	//! \brief 시작 시간
 	inline time_t getStart(void) const { return m_start.child; }
 
@@ -436,6 +514,29 @@ private:
 	void _closePair(int fd[2]);
 	bool _initChildInfo(void);
 
+	inline IoPoller*& _getPoller(void) { return t_reactor ? t_reactor->poller : m_poller.poller; }
+
+	bool _openListenerReusePort(const std::string& name, int type);
+
+	//! \brief 현재 차일드의 SO_REUSEPORT 리슨 소켓을 복제한다.
+	//! \return 없으면 -1을 반환한다.
+	int _dupListenerReusePort(const std::string& name, int& type) const;
+
+	//! \brief 차일드의 SO_REUSEPORT 리슨 소켓을 닫아 그룹에서 뺀다.
+	void _closeReusePort(size_t index);
+
+	//! \brief 닫아 둔 차일드의 SO_REUSEPORT 리슨 소켓을 다시 열어 그룹에 넣는다.
+	bool _reopenReusePort(size_t index);
+
+	template<typename _ListenerType>
+	bool _openListenerChildReusePort(const lsnr_names& names);
+
+	//! \brief start() 실패 처리. 리액터 스레드는 _Reactor::exit_code로만 돌려주고 프로세스 종료 코드를 건드리지 않는다.
+	inline int _failStart(void) { if ( not isReactor() ) m_exit_code = EXIT_FAILURE; return EXIT_FAILURE; }
+	bool _startReactor(size_t index, void* param);
+	void _runReactor(size_t index);
+	void _joinReactors(void);
+
 public:
 	//! \brief 싱글톤 객체.
 	static InstanceInterface*	s_inst;
@@ -452,7 +553,7 @@ public:
 		Log			err;		//!< 오류 로그 객체
 	} m_log;		//!< 로그 설정
 
-	lsnr_cont	m_lsnrs;		//!< 리스너 컨테이너
+	lsnr_cont	m_lsnrs;		//!< 리스너 컨테이너. 스레드 모드에서는 메인 스레드의 것이며 getListeners()를 쓴다.
 
 	struct {
 		int64_t			job;	//!< 잡 타임아웃
@@ -460,7 +561,7 @@ public:
 	} m_timeout;	//!< 타임아웃
 
 	struct {
-		JobManager	man;	//!< 잡 매니저.
+		JobManager	man;	//!< 잡 매니저. 스레드 모드에서는 메인 스레드의 것이며 getJobManager()를 쓴다.
 	} m_job;
 
 private:
@@ -476,10 +577,14 @@ private:
 	} m_poller;		//!< 폴러 정보
 
 	struct {
-		bool run;		//!< 실행 루프
+		bool			precise;	//!< timerfd 정밀 모드
+	} m_timer;		//!< 타이머 설정
+
+	struct {
+		std::atomic<bool> run;		//!< 실행 루프. 리액터 스레드와 공유한다.
 		bool reload;	//!< 환경설정 다시 읽기
 		bool stage;		//!< 스테이지 여부
-		bool check_child;	//!< 차일드가 죽었는지 확인
+		std::atomic<bool> check_child;	//!< 차일드가 죽었는지 확인
 	} m_flag;		//!< 일반적인 플래그
 
 	struct {
@@ -493,6 +598,11 @@ private:
 		size_t			dead_count;	//!< 죽은 차일드 개수
 		size_t			index;	//!< 차일드 인덱스. 부모일 경우 -1
 		child_type*		cont;	//!< 차일드 객체
+		bool			reuseport;	//!< 차일드마다 SO_REUSEPORT 리슨 소켓을 쓴다.
+		bool			reuseport_cpu;	//!< 접속을 받은 CPU로 차일드를 고른다.
+		Dispatch		dispatch;	//!< 분배 방식
+		size_t			rr;		//!< 라운드 로빈 위치
+		child_load_type*	load;	//!< 부하 테이블. 공유 메모리
 	} m_child;		//!< 차일드 설정
 
 	const struct _start {
@@ -513,6 +623,7 @@ private:
 		virtual ~_WakeUp();
 
 		void reopen(void);
+		void close(void);
 		bool setEventOut(void);
 
 	private:
@@ -524,13 +635,44 @@ private:
 
 	friend class InstanceInterface;
 	} m_wakeup;	//!< 폴러 강제 종료 객체
+
+	//! \brief 스레드 모드의 리액터.
+	//! \details 스레드마다 폴러, 잡 매니저, 리스너를 따로 가진다. 타이머는 스레드마다 하나씩이며, 환경설정은 메인 스레드와 공유하고 읽기만 한다.
+	struct _Reactor final
+	{
+		//! \brief 다른 스레드에서 리액터의 폴러를 깨운다.
+		class _Stop final : public Notifier
+		{
+		private:
+			void eventNotify(void) override {}
+		};
+
+		size_t		index;		//!< 차일드 인덱스
+		IoPoller*	poller{nullptr};
+		JobManager	job;
+		lsnr_cont	lsnrs;
+		_WakeUp		wakeup;
+		_Stop		notifier;
+		std::atomic<bool>	stop{false};	//!< 이 리액터만 멈춘다.
+		std::atomic<bool>	done{false};	//!< 스레드가 끝났다.
+		int			exit_code{EXIT_SUCCESS};
+		std::thread	thread;
+
+		explicit _Reactor(InstanceInterface& inst, size_t _index) : index(_index), wakeup(inst) {}
+	};
+
+	std::vector<std::unique_ptr<_Reactor>>	m_reactors;	//!< 스레드 모드 리액터. 인덱스는 차일드와 같다.
+	std::mutex	m_hook_lock;	//!< 리액터 스레드마다 부르는 초기화, 종료 함수를 한 번에 하나씩 부른다.
+
+	//! \brief 현재 스레드의 리액터. 메인 스레드는 nullptr이다.
+	static thread_local _Reactor*	t_reactor;
 };
 
 template<typename _ListenerType>
 bool
 InstanceInterface::openListenerSingle (const std::string& name)
 {
-	auto& ctx(this->m_lsnrs[name]);
+	auto& ctx(this->getListeners()[name]);
 	auto sslctx(this->getListenSslContext(name));
 	auto& plsnr(ctx.lsnr);
 	do {
@@ -562,7 +704,9 @@ template<int _ListenerType>
 bool
 InstanceInterface::openListenerParent(const std::string& name)
 {
-	auto& ctx(this->m_lsnrs[name]);
+	if ( this->isReusePort() ) return this->_openListenerReusePort(name, _ListenerType);
+
+	auto& ctx(this->getListeners()[name]);
 	auto& plsnr(ctx.lsnr);
 	do {
 		if ( plsnr ) { plsnr->close(); delete plsnr; plsnr = nullptr; }
@@ -592,7 +736,18 @@ template<typename _ListenerType>
 bool
 InstanceInterface::openListenerChild(void)
 {
-	if ( m_lsnrs.empty() )
+	auto& lsnrs(this->getListeners());
+	if ( this->isReusePort() )
+	{
+		lsnr_names names;
+		for ( auto& ctx : m_lsnrs )
+		{
+			if ( not ctx.second.reuseport.empty() ) names.insert(ctx.first);
+		}
+		return this->_openListenerChildReusePort<_ListenerType>(names);
+	}
+
+	if ( lsnrs.empty() )
 	{
 		this->logError(__FILE__, __LINE__, "no listener names. use InstanceInterface::openListenerChild(const lsnr_names& names) method.");
 		return false;
@@ -612,7 +767,7 @@ InstanceInterface::openListenerChild(void)
 		return false;
 	}
 
-	for ( auto& ctx : m_lsnrs )
+	for ( auto& ctx : lsnrs )
 	{
 		auto& clsnr(ctx.second.lsnr);
 		if ( clsnr ) { clsnr->close(); delete clsnr; }
@@ -634,6 +789,8 @@ InstanceInterface::openListenerChild(const lsnr_names& names)
 		return false;
 	}
 
+	if ( this->isReusePort() ) return this->_openListenerChildReusePort<_ListenerType>(names);
+
 	auto plsnr(new _ListenerType(this->getPoller()));
 	if ( nullptr == plsnr )
 	{
@@ -650,7 +807,7 @@ InstanceInterface::openListenerChild(const lsnr_names& names)
 
 	for ( auto& name : names )
 	{
-		auto& clsnr(this->m_lsnrs[name].lsnr);
+		auto& clsnr(this->getListeners()[name].lsnr);
 		if ( clsnr ) { clsnr->close(); delete clsnr; }
 
 		clsnr = plsnr;
@@ -659,6 +816,44 @@ InstanceInterface::openListenerChild(const lsnr_names& names)
 	return true;
 }
 
+//! \brief 이름마다 차일드 리스너를 만들어 SO_REUSEPORT 소켓에서 직접 접속을 받는다.
+template<typename _ListenerType>
+bool
+InstanceInterface::_openListenerChildReusePort(const lsnr_names& names)
+{
+	if ( names.empty() )
+	{
+		this->logError(__FILE__, __LINE__, "no reuseport listener");
+		return false;
+	}
+
+	for ( auto& name : names )
+	{
+		int type(ListenerInterface::LT_NONE);
+		const int fd(this->_dupListenerReusePort(name, type));
+		if ( -1 == fd )
+		{
+			this->logError(__FILE__, __LINE__, "no reuseport listener: name:%s", name.c_str());
+			return false;
+		}
+
+		auto& clsnr(this->getListeners()[name].lsnr);
+		if ( clsnr ) { clsnr->close(); delete clsnr; clsnr = nullptr; }
+
+		auto plsnr(new _ListenerType(this->getPoller()));
+		if ( not plsnr->openReusePort(fd, type) )
+		{
+			plsnr->close();
+			delete plsnr;
+			return false;
+		}
+
+		clsnr = plsnr;
+	}
+
+	return true;
+}
+
 };//namespace pw
 #endif//!__PW_INSTANCE_H__
 
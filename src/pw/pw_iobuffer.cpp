@@ -32,16 +32,174 @@
 #include "./pw_ssl.h"
 #include "./pw_log.h"
 
+#include <sys/uio.h>
+#include <sys/mman.h>
+
 namespace pw {
 
-IoBuffer::IoBuffer(size_t init_size, size_t delta_size) : m_init(init_size), m_buf(nullptr), m_posRead(nullptr), m_posWrite(nullptr), m_size(init_size), m_delta(delta_size)
+static size_t s_pool_limit(IoBufferPool::DEFAULT_LIMIT);
+
+//------------------------------------------------------------------------------
+// IoBufferPool
+
+IoBufferPool&
+IoBufferPool::s_getInstance(void)
+{
+	static thread_local IoBufferPool pool;
+	return pool;
+}
+
+void
+IoBufferPool::s_setLimit(size_t limit)
+{
+	s_pool_limit = limit;
+}
+
+size_t
+IoBufferPool::s_getLimit(void)
+{
+	return s_pool_limit;
+}
+
+size_t
+IoBufferPool::_getClassIndex(size_t size)
+{
+	if ( size <= MIN_CLASS_SIZE ) return 0;
+
+	// 2^hb < size <= 2^(hb+1)
+	size_t hb(0);
+	for ( size_t n(size-1); n > 1; n >>= 1 ) ++hb;
+
+	const size_t mid( size_t(3) << (hb-1) );
+	if ( size <= mid ) return (hb - MIN_SHIFT) * 2 + 1;
+
+	return (hb + 1 - MIN_SHIFT) * 2;
+}
+
+size_t
+IoBufferPool::s_getClassSize(size_t size)
+{
+	if ( size > MAX_CLASS_SIZE ) return size;
+
+	const size_t index(_getClassIndex(size));
+	const size_t shift( MIN_SHIFT + (index / 2) );
+
+	return ( index % 2 ) ? ( size_t(3) << (shift-1) ) : ( size_t(1) << shift );
+}
+
+IoBufferPool::~IoBufferPool()
+{
+	clear();
+}
+
+char*
+IoBufferPool::allocate(size_t size, size_t& cap)
+{
+	cap = s_getClassSize(size);
+
+	if ( cap <= MAX_CLASS_SIZE )
+	{
+		std::vector<char*>& cont(m_free[_getClassIndex(cap)]);
+		if ( not cont.empty() )
+		{
+			char* buf(cont.back());
+			cont.pop_back();
+
+			++m_stat.hit;
+			--m_stat.count;
+			m_stat.bytes -= cap;
+
+			return buf;
+		}
+	}
+
+	++m_stat.miss;
+	return static_cast<char*>(::malloc(cap));
+}
+
+char*
+IoBufferPool::reallocate(char* buf, size_t cap, size_t used, size_t size, size_t& ncap)
+{
+	if ( nullptr == buf ) return allocate(size, ncap);
+
+	ncap = s_getClassSize(size);
+	if ( ncap == cap ) return buf;
+
+	// 보관하지 않는 크기끼리는 realloc이 낫다.
+	if ( (cap > MAX_CLASS_SIZE) and (ncap > MAX_CLASS_SIZE) )
+	{
+		++m_stat.miss;
+		return static_cast<char*>(::realloc(buf, ncap));
+	}
+
+	char* nbuf(allocate(size, ncap));
+	if ( nullptr == nbuf ) return nullptr;
+
+	if ( used ) ::memcpy(nbuf, buf, std::min(used, ncap));
+	release(buf, cap);
+
+	return nbuf;
+}
+
+void
+IoBufferPool::release(char* buf, size_t cap)
+{
+	if ( nullptr == buf ) return;
+
+	if ( (cap <= MAX_CLASS_SIZE) and (m_stat.bytes + cap <= s_pool_limit) )
+	{
+		std::vector<char*>& cont(m_free[_getClassIndex(cap)]);
+		cont.push_back(buf);
+
+		++m_stat.release;
+		++m_stat.count;
+		m_stat.bytes += cap;
+
+		return;
+	}
+
+	++m_stat.drop;
+	::free(buf);
+}
+
+void
+IoBufferPool::clear(void)
+{
+	for ( auto& cont : m_free )
+	{
+		for ( auto buf : cont ) ::free(buf);
+		cont.clear();
+	}
+
+	m_stat.count = 0;
+	m_stat.bytes = 0;
+}
+
+std::ostream&
+IoBufferPool::dump(std::ostream& os) const
+{
+	os << "IoBufferPool: this: " << this
+		<< " limit: " << s_pool_limit
+		<< " hit: " << m_stat.hit
+		<< " miss: " << m_stat.miss
+		<< " release: " << m_stat.release
+		<< " drop: " << m_stat.drop
+		<< " count: " << m_stat.count
+		<< " bytes: " << m_stat.bytes;
+	return os;
+}
+
+//------------------------------------------------------------------------------
+// IoBuffer
+
+IoBuffer::IoBuffer(size_t init_size, size_t delta_size) : m_init(init_size), m_buf(nullptr), m_posRead(nullptr), m_posWrite(nullptr), m_size(init_size), m_cap(0), m_delta(delta_size)
 {
 	if ( m_init == 0 || m_init == size_t(-1) )
 	{
 		PWABORT("invalid iobuffer initialize size: %zu", m_init);
 	}
 
-	if ( nullptr == ( m_buf = static_cast<char*>(::malloc(m_init+1)) ) )
+	if ( nullptr == ( m_buf = IoBufferPool::s_getInstance().allocate(m_init+1, m_cap) ) )
 	{
 		PWABORT("not enough memory: init_size: %zu %s", init_size, strerror(errno));
 	}
@@ -59,12 +217,47 @@ IoBuffer::IoBuffer(size_t init_size, size_t delta_size) : m_init(init_size), m_b
 	//PWTRACE("iobuffer is successful: this:%p init:%zu size:%zu buf:%p", this, m_init, m_size, m_buf);
 }
 
+IoBuffer::IoBuffer(size_t init_size, size_t delta_size, std::nullptr_t) : m_init(init_size), m_buf(nullptr), m_posRead(nullptr), m_posWrite(nullptr), m_size(init_size), m_cap(0), m_delta(delta_size)
+{
+	if ( m_init == 0 || m_init == size_t(-1) )
+	{
+		PWABORT("invalid iobuffer initialize size: %zu", m_init);
+	}
+
+	if ( m_delta == 0 )
+	{
+		m_delta = 512;
+	}
+}
+
+IoBuffer*
+IoBuffer::s_create(Type type, size_t init_size, size_t delta_size)
+{
+	switch(type)
+	{
+	case Type::CHAIN: return new IoBufferChain(init_size, delta_size);
+	case Type::RING:
+	{
+		IoBufferRing* ring(new IoBufferRing(init_size, delta_size));
+		if ( ring->isAttached() ) return ring;
+
+		PWLOGLIB("failed to create ring buffer, use linear buffer: init_size: %zu", init_size);
+		delete ring;
+		break;
+	}
+	case Type::LINEAR: break;
+	}
+
+	return new IoBuffer(init_size, delta_size);
+}
+
 std::ostream&
 IoBuffer::dump(std::ostream& os, bool show_buf) const
 {
 	os << "IoBuffer: this: " << this
 		<< " m_init: " << m_init
 		<< " m_size: " << m_size
+		<< " m_cap: " << m_cap
 		<< " m_delta: " << m_delta
 		<< " m_posRead: " << static_cast<void*>(m_posRead)
 		<< " m_posWrite: " << static_cast<void*>(m_posWrite)
@@ -78,14 +271,51 @@ IoBuffer::~IoBuffer()
 {
 	if ( m_buf )
 	{
-		free(m_buf);
+		IoBufferPool::s_getInstance().release(m_buf, m_cap);
 		m_buf = nullptr;
 	}
 }
 
+bool
+IoBuffer::attach(void)
+{
+	if ( m_buf ) return true;
+
+	if ( nullptr == ( m_buf = IoBufferPool::s_getInstance().allocate(m_init+1, m_cap) ) )
+	{
+		PWLOGLIB("not enough memory: init_size: %zu %s", m_init, strerror(errno));
+		m_cap = 0;
+		return false;
+	}
+
+	m_posRead = m_posWrite = m_buf;
+	m_size = m_init;
+
+	return true;
+}
+
+bool
+IoBuffer::detach(void)
+{
+	if ( nullptr == m_buf ) return true;
+	if ( not isEmpty() ) return false;
+
+	IoBufferPool::s_getInstance().release(m_buf, m_cap);
+	m_buf = m_posRead = m_posWrite = nullptr;
+	m_size = m_cap = 0;
+
+	return true;
+}
+
 bool
 IoBuffer::grabWrite(blob_type& buf, size_t blen)
 {
+	if ( (nullptr == m_buf) and (not attach()) )
+	{
+		grabWrite(buf);
+		return false;
+	}
+
 	if ( isFlush() ) flush();
 
 	grabWrite(buf);
@@ -107,19 +337,27 @@ IoBuffer::grabWrite(blob_type& buf, size_t blen)
 void
 IoBuffer::decrease(size_t target_size)
 {
+	if ( nullptr == m_buf ) return;
+
 	if ( target_size == size_t(-1) ) target_size = m_init;
 	else if ( (not target_size) or (target_size == m_size) ) return;
 
 	const size_t cplen(getReadableSize());
 	if ( cplen ) flush();
 
-	char* nbuf(static_cast<char*>(::realloc(m_buf, target_size+1)));
+	// 줄인 크기에 내용이 들어가지 않으면 유지한다.
+	if ( target_size < cplen ) return;
+
+	size_t ncap(0);
+	char* nbuf(IoBufferPool::s_getInstance().reallocate(m_buf, m_cap, cplen, target_size+1, ncap));
 	if ( nullptr == nbuf )
 	{
 		PWLOGLIB("not enough memory: target_size: %zu %s", target_size, strerror(errno));
 		return;
 	}
 
+	m_cap = ncap;
+
 	if ( nbuf not_eq m_buf )
 	{
 		m_buf = nbuf;
@@ -135,6 +373,13 @@ IoBuffer::increase(size_t delta)
 {
 	//PWSHOWMETHOD();
 	if ( not delta ) return false;
+	if ( nullptr == m_buf )
+	{
+		// 떨어진 저장소는 기본 크기로 다시 붙인 뒤 모자란 만큼만 늘린다.
+		if ( not attach() ) return false;
+		if ( delta <= m_size ) return true;
+		delta -= m_size;
+	}
 
 	const size_t cplen(getReadableSize());
 	if ( cplen ) flush();
@@ -142,13 +387,23 @@ IoBuffer::increase(size_t delta)
 	const size_t target_size(m_size+delta);
 	PWTRACE("%s %p now:%zu target:%zu", __func__, this, m_size, target_size);
 
-	char* nbuf ( static_cast<char*>(::realloc(m_buf, target_size+1)) );
+	// 같은 등급 안에서는 크기만 늘린다.
+	if ( target_size < m_cap )
+	{
+		m_size = target_size;
+		return true;
+	}
+
+	size_t ncap(0);
+	char* nbuf ( IoBufferPool::s_getInstance().reallocate(m_buf, m_cap, cplen, target_size+1, ncap) );
 	if ( nullptr == nbuf )
 	{
 		PWLOGLIB("not enough memory: target_size: %zu %s", target_size, strerror(errno));
 		return false;
 	}
 
+	m_cap = ncap;
+
 	if ( nbuf not_eq m_buf )
 	{
 		m_buf = nbuf;
@@ -165,6 +420,8 @@ void
 IoBuffer::flush(void)
 {
 	//PWTRACE("flush!");
+	if ( nullptr == m_buf ) return;
+
 	if ( m_posRead == m_buf )
 	{
 		PWTRACE("skip flush!");
@@ -197,11 +454,19 @@ IoBuffer::writeToBuffer(const char* buf, size_t blen)
 
 	//PWTRACE("class: %p buf:%p b.buf:%p", this, m_buf, b.buf);
 	::memcpy(b.buf, buf, cplen);
-	m_posWrite += cplen;
+	moveWrite(cplen);
 
 	return cplen;
 }
 
+ssize_t
+IoBuffer::writeToBuffer(const shared_blob_type& blob)
+{
+	if ( (not blob) or blob->empty() ) return 0;
+
+	return this->writeToBuffer(blob->buf, blob->size);
+}
+
 ssize_t
 IoBuffer::writeToFile(int fd)
 {
@@ -212,7 +477,7 @@ IoBuffer::writeToFile(int fd)
 		const ssize_t cplen(::write(fd, b.buf, b.size));
 		if ( cplen > 0 )
 		{
-			m_posRead += cplen;
+			moveRead(size_t(cplen));
 			return cplen;
 		}
 		else if ( cplen == 0 ) return 0;
@@ -230,7 +495,7 @@ IoBuffer::readFromBuffer(char* buf, size_t blen)
 	grabRead(b);
 	const size_t cplen(std::min(blen, b.size));
 	::memcpy(buf, b.buf, cplen);
-	m_posRead += cplen;
+	moveRead(cplen);
 
 	return cplen;
 }
@@ -243,7 +508,7 @@ IoBuffer::readFromBuffer ( string& buf, size_t blen )
 	auto cplen(std::min(blen, b.size));
 	if ( cplen ) buf.assign(b.buf, cplen);
 	else buf.clear();
-	m_posRead += cplen;
+	moveRead(cplen);
 
 	return cplen;
 }
@@ -255,7 +520,7 @@ IoBuffer::readFromBufferAll ( string& buf )
 	grabRead(b);
 	if ( b.size ) buf.assign(b.buf, b.size);
 	else buf.clear();
-	m_posRead += b.size;
+	moveRead(b.size);
 
 	return b.size;
 }
@@ -263,6 +528,7 @@ IoBuffer::readFromBufferAll ( string& buf )
 ssize_t
 IoBuffer::readFromFile(int fd)
 {
+	if ( (nullptr == m_buf) and (not attach()) ) return ssize_t(-1);
 	if ( isFlush() ) flush();
 
 	if ( getWriteableSize() == 0 )
@@ -299,15 +565,19 @@ IoBuffer::clear(void)
 bool
 IoBuffer::peekLine(Tokenizer& tok) const
 {
-	const char* p(m_posRead);
-	size_t rlen(getReadableSize()), gap;
+	blob_type b;
+	grabRead(b);
+
+	const char* p(b.buf);
+	const char* const pend(b.buf + b.size);
+	size_t rlen(b.size), gap;
 
 	while ( nullptr != ( p = (char*)memchr(p, '\n', rlen) ) )
 	{
-		if ( (gap = size_t(p - m_posRead)) < 1 )
+		if ( (gap = size_t(p - b.buf)) < 1 )
 		{
 			++p;
-			if ( p == m_posWrite ) break;
+			if ( p == pend ) break;
 			rlen -= 1;
 		}
 
@@ -315,7 +585,7 @@ IoBuffer::peekLine(Tokenizer& tok) const
 
 		if ( *(p-1) == '\r' )
 		{
-			tok.setBuffer(m_posRead, gap-1);
+			tok.setBuffer(b.buf, gap-1);
 			return true;
 		}
 
@@ -328,15 +598,19 @@ IoBuffer::peekLine(Tokenizer& tok) const
 bool
 IoBuffer::getLine(std::string& out)
 {
-	const char* p(m_posRead);
-	size_t rlen(getReadableSize()), gap;
+	blob_type b;
+	grabRead(b);
+
+	const char* p(b.buf);
+	const char* const pend(b.buf + b.size);
+	size_t rlen(b.size), gap;
 
 	while ( nullptr != ( p = (char*)memchr(p, '\n', rlen) ) )
 	{
-		if ( (gap = size_t(p - m_posRead)) < 1 )
+		if ( (gap = size_t(p - b.buf)) < 1 )
 		{
 			++p;
-			if ( p == m_posWrite ) break;
+			if ( p == pend ) break;
 			rlen -= 1;
 		}
 
@@ -344,7 +618,7 @@ IoBuffer::getLine(std::string& out)
 
 		if ( *(p-1) == '\r' )
 		{
-			out.assign(m_posRead, gap-1);
+			out.assign(b.buf, gap-1);
 			moveRead(gap+1);
 			return true;
 		}
@@ -358,15 +632,19 @@ IoBuffer::getLine(std::string& out)
 size_t
 IoBuffer::getLine(char* buf, size_t blen)
 {
-	const char* p(m_posRead);
-	size_t rlen(getReadableSize()), gap(0);
+	blob_type b;
+	grabRead(b);
+
+	const char* p(b.buf);
+	const char* const pend(b.buf + b.size);
+	size_t rlen(b.size), gap(0);
 
 	while ( nullptr != ( p = (char*)memchr(p, '\n', rlen) ) )
 	{
-		if ( (gap = size_t(p - m_posRead)) < 1 )
+		if ( (gap = size_t(p - b.buf)) < 1 )
 		{
 			++p;
-			if ( p == m_posWrite ) break;
+			if ( p == pend ) break;
 			rlen -= 1;
 		}
 
@@ -382,7 +660,7 @@ IoBuffer::getLine(char* buf, size_t blen)
 
 		if ( *(p-1) == '\r' )
 		{
-			::memcpy(buf, m_posRead, gap);
+			::memcpy(buf, b.buf, gap);
 			if ( gap < blen ) buf[gap] = 0x00;
 			moveRead(gap+2);
 			return gap;
@@ -399,6 +677,7 @@ IoBufferSsl::readFromFile(int)
 {
 	if ( m_ssl )
 	{
+		if ( (nullptr == m_buf) and (not attach()) ) return ssize_t(-1);
 		if ( isFlush() ) flush();
 
 		if ( getWriteableSize() == 0 )
@@ -447,4 +726,557 @@ IoBufferSsl::writeToFile(int)
 	return ssize_t(-1);
 }
 
+//------------------------------------------------------------------------------
+// IoBufferChain
+
+IoBufferChain::IoBufferChain(size_t init_size, size_t delta_size) : IoBuffer(init_size, delta_size, nullptr)
+{
+	if ( not _append(m_init) )
+	{
+		PWABORT("not enough memory: init_size: %zu %s", init_size, strerror(errno));
+	}
+}
+
+IoBufferChain::~IoBufferChain()
+{
+	for ( auto& seg : m_segs ) _release(seg);
+	m_segs.clear();
+}
+
+std::ostream&
+IoBufferChain::dump(std::ostream& os, bool show_buf) const
+{
+	os << "IoBufferChain: this: " << this
+		<< " m_init: " << m_init
+		<< " segments: " << m_segs.size()
+		<< " readable: " << m_readable
+		<< " writeable: " << getWriteableSize();
+
+	if ( show_buf )
+	{
+		for ( auto& seg : m_segs )
+		{
+			os << " [buf: " << static_cast<void*>(seg.buf)
+				<< " size: " << seg.size
+				<< " rpos: " << seg.rpos
+				<< " wpos: " << seg.wpos
+				<< (seg.ref ? " ref]" : "]");
+		}
+	}
+
+	return os;
+}
+
+char*
+IoBufferChain::_allocate(size_t size, size_t& cap) const
+{
+	char* buf(IoBufferPool::s_getInstance().allocate(size, cap));
+	if ( nullptr == buf )
+	{
+		PWLOGLIB("not enough memory: size: %zu %s", size, strerror(errno));
+	}
+
+	return buf;
+}
+
+void
+IoBufferChain::_release(segment_type& seg) const
+{
+	if ( seg.ref )
+	{
+		seg.ref.reset();
+	}
+	else if ( seg.buf )
+	{
+		IoBufferPool::s_getInstance().release(seg.buf, seg.size);
+	}
+
+	seg.buf = nullptr;
+	seg.size = seg.rpos = seg.wpos = 0;
+}
+
+bool
+IoBufferChain::_append(size_t size)
+{
+	size_t cap(0);
+	char* buf(_allocate(size, cap));
+	if ( nullptr == buf ) return false;
+
+	m_segs.push_back(segment_type(buf, cap));
+	return true;
+}
+
+void
+IoBufferChain::_pullup(void) const
+{
+	size_t cap(0);
+	char* buf(_allocate(std::max(m_readable, m_init), cap));
+	if ( nullptr == buf ) return;
+
+	PWTRACE("%s %p segments:%zu readable:%zu", __func__, this, m_segs.size(), m_readable);
+
+	segment_type nseg(buf, cap);
+	for ( auto& seg : m_segs )
+	{
+		const size_t rlen(seg.getReadableSize());
+		if ( rlen )
+		{
+			::memcpy(buf + nseg.wpos, seg.buf + seg.rpos, rlen);
+			nseg.wpos += rlen;
+		}
+
+		_release(seg);
+	}
+
+	m_segs.clear();
+	m_segs.push_back(std::move(nseg));
+}
+
+size_t
+IoBufferChain::getWriteableSize(void) const
+{
+	if ( m_segs.empty() ) return 0;
+	return m_segs.back().getWriteableSize();
+}
+
+bool
+IoBufferChain::grabRead(blob_type& buf) const
+{
+	if ( m_segs.empty() )
+	{
+		buf.buf = nullptr;
+		buf.size = 0;
+		return true;
+	}
+
+	if ( m_segs.front().getReadableSize() not_eq m_readable ) _pullup();
+
+	const segment_type& seg(m_segs.front());
+	buf.buf = seg.buf + seg.rpos;
+	buf.size = seg.getReadableSize();
+
+	return true;
+}
+
+bool
+IoBufferChain::grabWrite(blob_type& buf) const
+{
+	if ( m_segs.empty() )
+	{
+		buf.buf = nullptr;
+		buf.size = 0;
+		return true;
+	}
+
+	const segment_type& seg(m_segs.back());
+	buf.buf = seg.buf + seg.wpos;
+	buf.size = seg.getWriteableSize();
+
+	return true;
+}
+
+bool
+IoBufferChain::grabWrite(blob_type& buf, size_t blen)
+{
+	if ( getWriteableSize() < blen )
+	{
+		// 내용이 없는 마지막 세그먼트는 새로 할당할 세그먼트로 교체한다.
+		if ( (not m_segs.empty()) and (0 == m_segs.back().getReadableSize()) )
+		{
+			_release(m_segs.back());
+			m_segs.pop_back();
+		}
+
+		if ( not _append(std::max(blen, m_init)) )
+		{
+			grabWrite(buf);
+			return false;
+		}
+	}
+
+	grabWrite(buf);
+	return true;
+}
+
+bool
+IoBufferChain::moveRead(const size_t blen)
+{
+	if ( blen > m_readable ) return false;
+
+	size_t left(blen);
+	while ( left )
+	{
+		segment_type& seg(m_segs.front());
+		const size_t cplen(std::min(left, seg.getReadableSize()));
+		seg.rpos += cplen;
+		left -= cplen;
+
+		if ( (seg.rpos == seg.wpos) and (m_segs.size() > 1) )
+		{
+			_release(seg);
+			m_segs.pop_front();
+		}
+	}
+
+	m_readable -= blen;
+	if ( 0 == m_readable ) flush();
+
+	return true;
+}
+
+bool
+IoBufferChain::moveWrite(const size_t blen)
+{
+	if ( blen > getWriteableSize() ) return false;
+
+	m_segs.back().wpos += blen;
+	m_readable += blen;
+
+	return true;
+}
+
+ssize_t
+IoBufferChain::writeToBuffer(const shared_blob_type& blob)
+{
+	if ( (not blob) or blob->empty() ) return 0;
+
+	// 남은 공간에 들어가면 복사하는 편이 세그먼트를 늘리는 것보다 싸다.
+	if ( blob->size <= getWriteableSize() ) return IoBuffer::writeToBuffer(blob->buf, blob->size);
+
+	if ( (not m_segs.empty()) and (0 == m_segs.back().getReadableSize()) )
+	{
+		_release(m_segs.back());
+		m_segs.pop_back();
+	}
+
+	segment_type seg(const_cast<char*>(blob->buf), blob->size);
+	seg.wpos = blob->size;
+	seg.ref = blob;
+	m_segs.push_back(std::move(seg));
+	m_readable += blob->size;
+
+	return blob->size;
+}
+
+bool
+IoBufferChain::increase(size_t delta)
+{
+	if ( not delta ) return false;
+
+	blob_type b;
+	return grabWrite(b, delta);
+}
+
+void
+IoBufferChain::decrease(size_t)
+{
+	flush();
+}
+
+void
+IoBufferChain::flush(void)
+{
+	// 읽을 내용이 남아 있으면 옮길 필요가 없다.
+	if ( m_readable ) return;
+
+	while ( m_segs.size() > 1 )
+	{
+		_release(m_segs.front());
+		m_segs.pop_front();
+	}
+
+	if ( not m_segs.empty() )
+	{
+		segment_type& seg(m_segs.front());
+		// 기본 크기 세그먼트 하나만 남긴다.
+		if ( seg.ref or (seg.size not_eq IoBufferPool::s_getClassSize(m_init)) )
+		{
+			_release(seg);
+			m_segs.pop_front();
+		}
+		else
+		{
+			seg.rpos = seg.wpos = 0;
+		}
+	}
+}
+
+bool
+IoBufferChain::attach(void)
+{
+	if ( not m_segs.empty() ) return true;
+
+	return _append(m_init);
+}
+
+bool
+IoBufferChain::detach(void)
+{
+	if ( m_readable ) return false;
+
+	for ( auto& seg : m_segs ) _release(seg);
+	m_segs.clear();
+
+	return true;
+}
+
+void
+IoBufferChain::clear(void)
+{
+	m_readable = 0;
+	flush();
+}
+
+ssize_t
+IoBufferChain::readFromFile(int fd)
+{
+	if ( (0 == getWriteableSize()) and (not _append(m_init)) ) return ssize_t(-1);
+
+	blob_type b;
+	grabWrite(b);
+
+	// 남은 공간을 넘치면 다음 세그먼트로 이어 읽는다.
+	size_t ncap(0);
+	char* next(_allocate(m_init, ncap));
+
+	struct iovec iov[2];
+	int count(1);
+	iov[0].iov_base = b.buf;
+	iov[0].iov_len = b.size;
+	if ( next )
+	{
+		iov[1].iov_base = next;
+		iov[1].iov_len = ncap;
+		++count;
+	}
+
+	const ssize_t cplen(::readv(fd, iov, count));
+	if ( cplen > 0 )
+	{
+		const size_t first(std::min(size_t(cplen), b.size));
+		moveWrite(first);
+
+		if ( size_t(cplen) > first )
+		{
+			m_segs.push_back(segment_type(next, ncap));
+			moveWrite(size_t(cplen) - first);
+			next = nullptr;
+		}
+	}
+
+	if ( next )
+	{
+		IoBufferPool::s_getInstance().release(next, ncap);
+	}
+
+	if ( cplen > 0 ) return cplen;
+	else if ( cplen == 0 ) return ssize_t(0);
+
+	return ssize_t(-1);
+}
+
+ssize_t
+IoBufferChain::writeToFile(int fd)
+{
+	if ( 0 == m_readable ) return 0;
+
+	struct iovec iov[IOV_COUNT];
+	int count(0);
+	for ( auto& seg : m_segs )
+	{
+		if ( count == IOV_COUNT ) break;
+
+		const size_t rlen(seg.getReadableSize());
+		if ( 0 == rlen ) continue;
+
+		iov[count].iov_base = seg.buf + seg.rpos;
+		iov[count].iov_len = rlen;
+		++count;
+	}
+
+	const ssize_t cplen(::writev(fd, iov, count));
+	if ( cplen > 0 )
+	{
+		moveRead(size_t(cplen));
+		return cplen;
+	}
+	else if ( cplen == 0 ) return 0;
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// IoBufferRing
+
+IoBufferRing::IoBufferRing(size_t init_size, size_t delta_size) : IoBuffer(init_size, delta_size, nullptr)
+{
+	m_size = 0;
+	attach();
+}
+
+IoBufferRing::~IoBufferRing()
+{
+	if ( m_buf )
+	{
+		_unmap(m_buf, m_size);
+		m_buf = m_posRead = m_posWrite = nullptr;
+	}
+}
+
+size_t
+IoBufferRing::_roundUp(size_t size)
+{
+	static const size_t page(size_t(::sysconf(_SC_PAGESIZE)));
+	if ( 0 == size ) size = 1;
+
+	return ( (size + page - 1) / page ) * page;
+}
+
+char*
+IoBufferRing::_map(size_t cap)
+{
+#ifdef HAVE_MEMFD_CREATE
+	const int fd(::memfd_create("pw_iobuffer_ring", MFD_CLOEXEC));
+	if ( fd < 0 )
+	{
+		PWLOGLIB("failed to create memfd: %s", strerror(errno));
+		return nullptr;
+	}
+
+	char* buf(nullptr);
+	do {
+		if ( ::ftruncate(fd, off_t(cap)) < 0 ) break;
+
+		// 두 배 크기의 주소 공간을 잡은 뒤, 같은 파일을 앞뒤로 겹쳐 매핑한다.
+		void* p(::mmap(nullptr, cap*2, PROT_NONE, MAP_PRIVATE bitor MAP_ANONYMOUS, -1, 0));
+		if ( MAP_FAILED == p ) break;
+
+		char* base(static_cast<char*>(p));
+		if ( (MAP_FAILED == ::mmap(base, cap, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_FIXED, fd, 0))
+			or (MAP_FAILED == ::mmap(base + cap, cap, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_FIXED, fd, 0)) )
+		{
+			::munmap(base, cap*2);
+			break;
+		}
+
+		::madvise(base, cap*2, MADV_DONTFORK);
+		buf = base;
+	} while (false);
+
+	if ( nullptr == buf )
+	{
+		PWLOGLIB("failed to map ring buffer: cap:%zu %s", cap, strerror(errno));
+	}
+
+	::close(fd);
+	return buf;
+#else
+	PWLOGLIB("not supported ring buffer: cap:%zu", cap);
+	return nullptr;
+#endif
+}
+
+void
+IoBufferRing::_unmap(char* buf, size_t cap)
+{
+	if ( buf ) ::munmap(buf, cap*2);
+}
+
+bool
+IoBufferRing::_remap(size_t cap)
+{
+	const size_t cplen(getReadableSize());
+	if ( cap < cplen ) return false;
+
+	char* nbuf(_map(cap));
+	if ( nullptr == nbuf ) return false;
+
+	if ( cplen ) ::memcpy(nbuf, m_posRead, cplen);
+	_unmap(m_buf, m_size);
+
+	m_buf = m_posRead = nbuf;
+	m_posWrite = nbuf + cplen;
+	m_size = cap;
+
+	return true;
+}
+
+bool
+IoBufferRing::attach(void)
+{
+	if ( m_buf ) return true;
+
+	return _remap(_roundUp(m_init));
+}
+
+bool
+IoBufferRing::detach(void)
+{
+	if ( nullptr == m_buf ) return true;
+	if ( not isEmpty() ) return false;
+
+	_unmap(m_buf, m_size);
+	m_buf = m_posRead = m_posWrite = nullptr;
+	m_size = 0;
+
+	return true;
+}
+
+bool
+IoBufferRing::increase(size_t delta)
+{
+	if ( not delta ) return false;
+	if ( nullptr == m_buf )
+	{
+		if ( not attach() ) return false;
+		if ( delta <= m_size ) return true;
+		delta -= m_size;
+	}
+
+	PWTRACE("%s %p now:%zu target:%zu", __func__, this, m_size, m_size + delta);
+	return _remap(_roundUp(m_size + delta));
+}
+
+void
+IoBufferRing::decrease(size_t target_size)
+{
+	if ( nullptr == m_buf ) return;
+
+	if ( target_size == size_t(-1) ) target_size = m_init;
+	else if ( not target_size ) return;
+
+	const size_t cap(_roundUp(std::max(target_size, getReadableSize())));
+	if ( cap >= m_size ) return;
+
+	_remap(cap);
+}
+
+void
+IoBufferRing::flush(void)
+{
+	// 비었을 때 처음으로 되돌리는 것 외에는 할 일이 없다.
+	if ( m_buf and (m_posRead == m_posWrite) ) m_posRead = m_posWrite = m_buf;
+}
+
+void
+IoBufferRing::clear(void)
+{
+	m_posRead = m_posWrite = m_buf;
+}
+
+bool
+IoBufferRing::moveRead(const size_t blen)
+{
+	m_posRead += blen;
+
+	// 읽기 위치가 미러 영역으로 넘어가면 앞쪽으로 되돌린다.
+	if ( m_posRead >= (m_buf + m_size) )
+	{
+		m_posRead -= m_size;
+		m_posWrite -= m_size;
+	}
+
+	return true;
+}
+
 };//namespace pw
@@ -38,6 +38,80 @@ namespace pw {
 
 class Ssl;
 
+//! \brief IO 버퍼 저장소 풀.
+//! \details 크기 등급별로 해제된 블록을 보관했다가 재사용한다.
+//!	등급은 1KiB ~ 1MiB 사이의 2^n, 3*2^(n-1) 크기이다.
+//!	최대 등급보다 큰 블록은 보관하지 않는다.
+//!	스레드마다 인스턴스가 있으므로 잠금이 없다.
+class IoBufferPool final
+{
+public:
+	enum
+	{
+		MIN_SHIFT = 10,
+		MAX_SHIFT = 20,
+		MIN_CLASS_SIZE = (1 << MIN_SHIFT),
+		MAX_CLASS_SIZE = (1 << MAX_SHIFT),
+		CLASS_COUNT = (MAX_SHIFT - MIN_SHIFT) * 2 + 1,
+		DEFAULT_LIMIT = 1024*1024*16,
+	};
+
+	//! \brief 통계
+	struct stat_type final
+	{
+		size_t	hit{0};		//!< 풀에서 할당
+		size_t	miss{0};	//!< 새로 할당
+		size_t	release{0};	//!< 풀에 반환
+		size_t	drop{0};	//!< 제한을 넘어 해제
+		size_t	count{0};	//!< 보관 중인 블록 수
+		size_t	bytes{0};	//!< 보관 중인 바이트
+	};
+
+public:
+	//! \brief 현재 스레드의 풀
+	static IoBufferPool& s_getInstance(void);
+
+	//! \brief 스레드마다 보관할 최대 바이트. 0이면 보관하지 않는다.
+	static void s_setLimit(size_t limit);
+	static size_t s_getLimit(void);
+
+	//! \brief 크기에 맞는 등급 크기. 최대 등급보다 크면 그대로 돌려준다.
+	static size_t s_getClassSize(size_t size);
+
+public:
+	//! \brief 블록 할당
+	//! \param[in] size 필요한 크기
+	//! \param[out] cap 실제 용량
+	char* allocate(size_t size, size_t& cap);
+
+	//! \brief 블록 크기 변경. 앞의 used 바이트를 보존한다.
+	char* reallocate(char* buf, size_t cap, size_t used, size_t size, size_t& ncap);
+
+	//! \brief 블록 반환
+	//! \param[in] cap allocate에서 받은 용량
+	void release(char* buf, size_t cap);
+
+	//! \brief 보관 중인 블록을 모두 해제한다.
+	void clear(void);
+
+	inline const stat_type& getStat(void) const { return m_stat; }
+	std::ostream& dump(std::ostream& os) const;
+
+public:
+	IoBufferPool() = default;
+	~IoBufferPool();
+
+	IoBufferPool(const IoBufferPool&) = delete;
+	IoBufferPool& operator = (const IoBufferPool&) = delete;
+
+private:
+	static size_t _getClassIndex(size_t size);
+
+private:
+	std::vector<char*>	m_free[CLASS_COUNT];
+	stat_type			m_stat;
+};
+
 //! \brief IO 버퍼.
 //	|---DUMMY---|---READABLE---|---WRITABLE---|
 //	m_buf       m_posRead      m_posWrite
@@ -50,6 +124,14 @@ public:
 		DEFAULT_DELTA = DEFAULT_SIZE / 2
 	};
 
+	//! \brief 버퍼 형태
+	enum class Type
+	{
+		LINEAR,	//!< 하나의 연속된 버퍼
+		CHAIN,	//!< 고정 크기 세그먼트 체인. IoBufferChain
+		RING,	//!< 이중 매핑 링 버퍼. IoBufferRing
+	};
+
 	struct blob_type final
 	{
 		char*	buf = nullptr;
@@ -65,18 +147,30 @@ public:
 		blob_type& operator = (blob_type&&) = default;
 	};
 
+	//! \brief 참조로 넘길 수 있는 공유 버퍼
+	using shared_blob_type = std::shared_ptr<const ::pw::blob_type>;
+
 public:
 	explicit IoBuffer(size_t init_size = DEFAULT_SIZE, size_t delta_size = DEFAULT_DELTA);
 	virtual ~IoBuffer();
 
+	//! \brief 형태에 맞는 버퍼를 생성한다.
+	static IoBuffer* s_create(Type type, size_t init_size = DEFAULT_SIZE, size_t delta_size = DEFAULT_DELTA);
+
 public:
-	std::ostream& dump(std::ostream& os, bool show_buf = false) const;
+	virtual std::ostream& dump(std::ostream& os, bool show_buf = false) const;
 
 	virtual ssize_t readFromFile(int fd);
 	virtual ssize_t writeToFile(int fd);
 
 	ssize_t writeToBuffer(const char* buf, size_t blen);
 	ssize_t writeToBuffer(const std::string& buf) { return this->writeToBuffer(buf.c_str(), buf.size()); }
+
+	//! \brief 공유 버퍼를 쓴다.
+	//! \details 기본 버퍼는 복사하고, 체인 버퍼는 복사 없이 참조만 연결한다.
+	//!	참조된 내용은 모두 전송될 때까지 변경하면 안 된다.
+	virtual ssize_t writeToBuffer(const shared_blob_type& blob);
+
 	ssize_t readFromBuffer(char* buf, size_t blen);
 	ssize_t readFromBuffer(std::string& buf, size_t blen);
 	ssize_t readFromBufferAll(std::string& buf);
@@ -85,16 +179,26 @@ public:
 	bool getLine(std::string& out);
 	size_t getLine(char* buf, size_t blen);
 
-	inline bool isEmpty(void) const { return ( m_posRead == m_posWrite ); }
-	inline bool isFull(void) const { return (m_posWrite == (m_buf +  m_size)); }
+	virtual bool isEmpty(void) const { return ( m_posRead == m_posWrite ); }
+	virtual bool isFull(void) const { return (m_posWrite == (m_buf +  m_size)); }
 
-	bool increase(size_t delta);
-	void decrease(size_t target_size = size_t(-1));
-	void flush(void);
-	void clear(void);
+	virtual bool increase(size_t delta);
+	virtual void decrease(size_t target_size = size_t(-1));
+	virtual void flush(void);
+	virtual void clear(void);
+
+	//! \brief 저장소가 붙어 있는지 여부
+	virtual bool isAttached(void) const { return ( nullptr not_eq m_buf ); }
+
+	//! \brief 풀에서 저장소를 받는다. 쓰기 전에 자동으로 호출한다.
+	virtual bool attach(void);
+
+	//! \brief 비어 있으면 저장소를 풀에 돌려준다.
+	//! \return 저장소가 떨어져 있으면 true.
+	virtual bool detach(void);
 
 	//! \brief Dummy 공간 비우기 판단
-	inline bool isFlush(void) const
+	virtual bool isFlush(void) const
 	{
 		const size_t th(m_size/2);
 
@@ -102,19 +206,19 @@ public:
 	}
 
 	//! \brief Flush 한 뒤, 얻을 수 있는 사용한 공간.
-	inline size_t getDummySize(void) const
+	virtual size_t getDummySize(void) const
 	{
 		return size_t (m_posRead - m_buf);
 	}
 
 	//! \brief 버퍼에 쓸 수 있는 공간.
-	inline size_t getWriteableSize(void) const
+	virtual size_t getWriteableSize(void) const
 	{
 		return (m_size - size_t(m_posWrite - m_buf));
 	}
 
 	//! \brief 버퍼에 쓴 공간.
-	inline size_t getReadableSize(void) const
+	virtual size_t getReadableSize(void) const
 	{
 		return size_t(m_posWrite - m_posRead);
 	}
@@ -124,7 +228,7 @@ public:
 	// Dangerous methods.
 	// DO NOT USE THESE DIRECTLY!
 
-	inline bool grabRead(blob_type& buf) const
+	virtual bool grabRead(blob_type& buf) const
 	{
 		buf.buf = m_posRead;
 		buf.size = getReadableSize();
@@ -132,7 +236,7 @@ public:
 		return true;
 	}
 
-	inline bool grabWrite(blob_type& buf) const
+	virtual bool grabWrite(blob_type& buf) const
 	{
 		buf.buf = m_posWrite;
 		buf.size = getWriteableSize();
@@ -140,26 +244,31 @@ public:
 		return true;
 	}
 
-	bool grabWrite(blob_type& buf, size_t aquire_size);
+	virtual bool grabWrite(blob_type& buf, size_t aquire_size);
 
-	bool moveRead(const size_t blen)
+	virtual bool moveRead(const size_t blen)
 	{
 		m_posRead += blen;
 		return true;
 	}
 
-	bool moveWrite(const size_t blen)
+	virtual bool moveWrite(const size_t blen)
 	{
 		m_posWrite += blen;
 		return true;
 	}
 
+protected:
+	//! \brief 버퍼를 할당하지 않는 생성자. 자체 저장소를 쓰는 파생 클래스용.
+	IoBuffer(size_t init_size, size_t delta_size, std::nullptr_t);
+
 protected:
 	const size_t	m_init;
 	char*			m_buf;
 	char*			m_posRead;
 	char*			m_posWrite;
 	size_t			m_size;
+	size_t			m_cap;	//!< 풀에서 받은 실제 용량. m_size+1 이상이다.
 	size_t			m_delta;
 };
 
@@ -177,6 +286,131 @@ protected:
 	Ssl*			m_ssl;
 };
 
+//! \brief 세그먼트 체인 IO 버퍼.
+//! \details 고정 크기 세그먼트를 이어 붙이므로 쓰기 중에 기존 내용을 옮기지 않는다.
+//!	writeToFile은 writev, readFromFile은 readv를 사용한다.
+//!	공유 버퍼는 복사하지 않고 세그먼트로 참조한다.
+//!	grabRead는 연속된 공간을 돌려줘야 하므로, 내용이 여러 세그먼트에
+//!	걸쳐 있으면 하나로 합친다. 쓰기 버퍼 용도에 적합하다.
+class IoBufferChain : public IoBuffer
+{
+public:
+	enum
+	{
+		IOV_COUNT = 64,	//!< writev 한 번에 사용하는 최대 세그먼트 수
+	};
+
+public:
+	explicit IoBufferChain(size_t init_size = DEFAULT_SIZE, size_t delta_size = DEFAULT_DELTA);
+	virtual ~IoBufferChain();
+
+public:
+	std::ostream& dump(std::ostream& os, bool show_buf = false) const override;
+
+	ssize_t readFromFile(int fd) override;
+	ssize_t writeToFile(int fd) override;
+
+	using IoBuffer::writeToBuffer;
+	ssize_t writeToBuffer(const shared_blob_type& blob) override;
+
+	inline bool isEmpty(void) const override { return ( 0 == m_readable ); }
+	inline bool isFull(void) const override { return ( 0 == getWriteableSize() ); }
+
+	bool increase(size_t delta) override;
+	void decrease(size_t target_size = size_t(-1)) override;
+	void flush(void) override;
+	void clear(void) override;
+
+	inline bool isAttached(void) const override { return not m_segs.empty(); }
+	bool attach(void) override;
+	bool detach(void) override;
+
+	//! \brief 옮길 내용이 없으므로 항상 거짓.
+	inline bool isFlush(void) const override { return false; }
+	inline size_t getDummySize(void) const override { return 0; }
+	size_t getWriteableSize(void) const override;
+	inline size_t getReadableSize(void) const override { return m_readable; }
+
+	//! \brief 세그먼트 개수
+	inline size_t getSegmentCount(void) const { return m_segs.size(); }
+
+public:
+	bool grabRead(blob_type& buf) const override;
+	bool grabWrite(blob_type& buf) const override;
+	bool grabWrite(blob_type& buf, size_t aquire_size) override;
+	bool moveRead(const size_t blen) override;
+	bool moveWrite(const size_t blen) override;
+
+private:
+	//! \brief 세그먼트
+	struct segment_type final
+	{
+		char*				buf{nullptr};	//!< 시작 위치
+		size_t				size{0};		//!< 용량
+		size_t				rpos{0};		//!< 읽기 위치
+		size_t				wpos{0};		//!< 쓰기 위치
+		shared_blob_type	ref;			//!< 참조 세그먼트의 원본. 없으면 자체 할당.
+
+		inline segment_type() = default;
+		inline segment_type(char* _buf, size_t _size) : buf(_buf), size(_size) {}
+
+		inline size_t getReadableSize(void) const { return wpos - rpos; }
+		inline size_t getWriteableSize(void) const { return ( ref ? 0 : size - wpos ); }
+	};
+
+	using seg_cont = std::deque<segment_type>;
+
+private:
+	char* _allocate(size_t size, size_t& cap) const;
+	void _release(segment_type& seg) const;
+	bool _append(size_t size);
+	void _pullup(void) const;
+
+private:
+	mutable seg_cont	m_segs;
+	size_t				m_readable{0};
+};
+
+//! \brief 링 IO 버퍼.
+//! \details 같은 memfd를 연속된 주소에 두 번 매핑하므로, 읽을 공간과 쓸 공간이
+//!	경계를 넘어도 항상 연속된다. flush에서 memmove를 하지 않는다.
+//!	용량은 페이지 단위로 올림한다.
+//!	매핑은 fork 시 자식에게 상속되지 않는다(MADV_DONTFORK).
+//!	매핑에 실패하면 isAttached()가 거짓이며, s_create는 기본 버퍼를 대신 만든다.
+//	|---WRITABLE---|---READABLE---|---WRITABLE---| (mirror)
+//	m_buf          m_posRead      m_posWrite     m_buf + m_size
+class IoBufferRing : public IoBuffer
+{
+public:
+	explicit IoBufferRing(size_t init_size = DEFAULT_SIZE, size_t delta_size = DEFAULT_DELTA);
+	virtual ~IoBufferRing();
+
+public:
+	inline bool isFull(void) const override { return ( getReadableSize() == m_size ); }
+
+	bool increase(size_t delta) override;
+	void decrease(size_t target_size = size_t(-1)) override;
+	void flush(void) override;
+	void clear(void) override;
+
+	bool attach(void) override;
+	bool detach(void) override;
+
+	//! \brief 옮길 내용이 없으므로 항상 거짓.
+	inline bool isFlush(void) const override { return false; }
+	inline size_t getDummySize(void) const override { return 0; }
+	inline size_t getWriteableSize(void) const override { return ( m_size - getReadableSize() ); }
+
+public:
+	bool moveRead(const size_t blen) override;
+
+private:
+	static size_t _roundUp(size_t size);
+	static char* _map(size_t cap);
+	static void _unmap(char* buf, size_t cap);
+	bool _remap(size_t cap);
+};
+
 }; //namespace pw;
 
 #endif//!__PW_IOBUFFER_H__
@@ -31,6 +31,9 @@
 #include "./pw_iopoller.h"
 #include "./pw_iopoller_select.h"
 #include "./pw_iopoller_epoll.h"
+#include "./pw_iopoller_uring.h"
+#include "./pw_timer.h"
+#include "./pw_log.h"
 
 namespace pw {
 
@@ -48,6 +51,20 @@ IoPoller::s_create(const char* type)
 
 #ifdef HAVE_EPOLL
 		if ( !strcasecmp("epoll", type) ) { poller =  new IoPoller_Epoll(); break; }
+		if ( !strcasecmp("epoll_et", type) ) { poller =  new IoPoller_Epoll(true); break; }
+#endif
+
+#ifdef HAVE_IO_URING
+		if ( !strcasecmp("uring", type) )
+		{
+			// 커널이 지원하지 않으면 기본 폴러를 사용한다.
+			poller = new IoPoller_Uring();
+			if ( poller->initialize() ) return poller;
+
+			PWLOGLIB("io_uring is not available. use default poller");
+			delete poller;
+			poller = nullptr;
+		}
 #endif
 
 	// by system default
@@ -97,4 +114,42 @@ IoPoller::s_release(IoPoller* poller)
 	delete poller;
 }
 
+void
+IoPoller::_endWait(void)
+{
+	Timer::s_refresh();
+	if ( m_busy ) m_busy->store(Timer::s_getNowMicro(), std::memory_order_relaxed);
+}
+
+IoPoller::event_type*
+IoPoller::EventTable::acquire(int fd)
+{
+	if ( fd < 0 ) return nullptr;
+
+	const size_t page(size_t(fd) >> PAGE_BITS);
+	if ( page >= m_pages.size() ) m_pages.resize(page+1, nullptr);
+
+	event_type*& ptr(m_pages[page]);
+	if ( nullptr == ptr )
+	{
+		ptr = new (std::nothrow) event_type[PAGE_FD_COUNT];
+		if ( nullptr == ptr ) return nullptr;
+		++m_count;
+	}
+
+	return ptr + (fd bitand (PAGE_FD_COUNT-1));
+}
+
+void
+IoPoller::EventTable::clear(void)
+{
+	for ( auto& ptr : m_pages )
+	{
+		if ( ptr ) delete [] ptr;
+	}
+
+	m_pages.clear();
+	m_count = 0;
+}
+
 };//namespace pw
@@ -29,6 +29,7 @@
  */
 
 #include "./pw_common.h"
+#include <atomic>
 
 #ifndef __PW_IOPOLLER_H__
 #define __PW_IOPOLLER_H__
@@ -62,6 +63,48 @@ public:
 		inline event_type() : fd(-1), mask(0), event(nullptr) {}
 	} event_type;
 
+	//! \brief FD별 이벤트 테이블.
+	//! \details 등록한 FD가 속한 페이지만 할당하므로 가장 큰 FD만큼만 메모리를 사용한다.
+	//!	페이지는 옮기지 않으므로, 한 번 얻은 event_type 주소는 clear 전까지 유지한다.
+	class EventTable final
+	{
+	public:
+		enum
+		{
+			PAGE_BITS = 10,
+			PAGE_FD_COUNT = (1 << PAGE_BITS),	//!< 페이지당 FD 개수
+		};
+
+	public:
+		//! \brief FD에 해당하는 항목. 페이지가 없으면 nullptr.
+		inline event_type* get(int fd)
+		{
+			const size_t page(size_t(fd) >> PAGE_BITS);
+			if ( (fd < 0) or (page >= m_pages.size()) or (nullptr == m_pages[page]) ) return nullptr;
+			return m_pages[page] + (fd bitand (PAGE_FD_COUNT-1));
+		}
+
+		//! \brief FD에 해당하는 항목. 페이지가 없으면 할당한다.
+		event_type* acquire(int fd);
+
+		//! \brief 모든 페이지 반환.
+		void clear(void);
+
+		//! \brief 할당한 페이지 개수.
+		inline size_t getPageCount(void) const { return m_count; }
+
+	public:
+		inline EventTable() = default;
+		inline ~EventTable() { clear(); }
+
+		EventTable(const EventTable&) = delete;
+		EventTable& operator = (const EventTable&) = delete;
+
+	private:
+		std::vector<event_type*>	m_pages;
+		size_t						m_count = 0;
+	};
+
 	//! \brief 폴러 클라이언트
 	class Event
 	{
@@ -72,6 +115,12 @@ public:
 		virtual void eventIo(int fd, int flags, bool& del_event) = 0;
 	};
 
+	enum
+	{
+		//! \brief 엣지 트리거 요청 마스크. isEdgeTriggered()가 참인 폴러만 반영하며, 나머지는 무시한다.
+		EDGE = 0x40000000,
+	};
+
 public:
 	//! \brief 폴러 생성.
 	static IoPoller* s_create(const char* type = nullptr);
@@ -101,6 +150,11 @@ public:
 	//! \brief 이벤트 디스패치
 	virtual ssize_t dispatch(int timeout_msec) = 0;
 
+	//! \brief 남은 준비 상태를 다음 디스패치에서 다시 알리도록 한다.
+	//! \details 엣지 트리거에서 EAGAIN 전에 처리를 멈출 때 호출한다.
+	//!	레벨 트리거 폴러는 남은 상태를 다시 알리므로 할 일이 없다.
+	virtual bool requeue(int /*fd*/) { return true; }
+
 	//! \brief 해당 클라이언트 얻기
 	virtual Event* getEvent(int fd) = 0;
 
@@ -108,10 +162,27 @@ public:
 	//! \brief 폴러 타입 문자열
 	virtual const char* getType(void) const = 0;
 
+	//! \brief EDGE 마스크를 엣지 트리거로 처리하는지 여부
+	virtual bool isEdgeTriggered(void) const { return false; }
+
+	//! \brief 이벤트를 처리하기 시작한 시각(us)을 기록할 곳을 설정한다.
+	//! \details 기다리는 동안은 0을, 기다림에서 돌아와 이벤트를 처리하는 동안은 그 시각을 쓴다.
+	//!	공유 메모리에 두면 다른 프로세스에서도 처리가 멈춘 폴러를 알아챌 수 있다.
+	inline void setBusyMarker(std::atomic<int64_t>* marker) { m_busy = marker; }
+
 protected:
 	virtual bool initialize(void) = 0;
 	virtual void destroy(void) = 0;
 
+	//! \brief 기다리기 전에 호출한다.
+	inline void _beginWait(void) { if ( m_busy ) m_busy->store(0, std::memory_order_relaxed); }
+
+	//! \brief 기다린 뒤 호출한다. 시간 캐시를 갱신하고 처리를 시작한 시각을 기록한다.
+	void _endWait(void);
+
+private:
+	std::atomic<int64_t>*	m_busy{nullptr};
+
 protected:
 	explicit IoPoller() {}
 	virtual ~IoPoller() {}
@@ -30,6 +30,7 @@
 
 #include "./pw_iopoller_epoll.h"
 #include "./pw_log.h"
+#include "./pw_timer.h"
 
 #ifdef HAVE_EPOLL
 
@@ -39,14 +40,26 @@ bool
 IoPoller_Epoll::add(int fd, Event* client, int mask)
 {
 	if ( -1 == m_epoll ) return false;
+	if ( fd >= MAX_EPOLL_SIZE )
+	{
+		PWLOGLIB("fd is out of range: fd: %d MAX: %d", fd, int(MAX_EPOLL_SIZE));
+		return false;
+	}
 
-	event_type& et(m_clients[fd]);
+	event_type* pet(m_clients.acquire(fd));
+	if ( nullptr == pet )
+	{
+		PWLOGLIB("failed to allocate event table: fd: %d", fd);
+		return false;
+	}
+
+	event_type& et(*pet);
 	et.fd = fd;
 	et.mask = mask;
 	et.event = client;
 
 	struct epoll_event ev;
-	ev.events = mask;
+	ev.events = toEpollMask(mask);
 	ev.data.ptr = &et;
 
 	if ( epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == -1 )
@@ -63,15 +76,17 @@ IoPoller_Epoll::remove(int fd)
 {
 	if ( -1 == m_epoll ) return false;
 
-	event_type& et(m_clients[fd]);
+	event_type* pet(m_clients.get(fd));
+	if ( nullptr == pet ) return false;
+
 	if ( epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr) == -1 )
 	{
 		return false;
 	}
 
-	et.event = nullptr;
-	et.fd = -1;
-	et.mask = 0;
+	pet->event = nullptr;
+	pet->fd = -1;
+	pet->mask = 0;
 
 	return true;
 }
@@ -79,10 +94,18 @@ IoPoller_Epoll::remove(int fd)
 bool
 IoPoller_Epoll::setMask(int fd, int mask)
 {
-	event_type& et(m_clients[fd]);
+	event_type* pet(m_clients.get(fd));
+	if ( nullptr == pet )
+	{
+		PWLOGLIB("failed to setMask: not registered: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	event_type& et(*pet);
+	if ( et.mask == mask ) return true;
 
 	struct epoll_event ev;
-	ev.events = mask;
+	ev.events = toEpollMask(mask);
 	ev.data.ptr = &et;
 
 	if ( epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == -1 )
@@ -96,14 +119,44 @@ IoPoller_Epoll::setMask(int fd, int mask)
 }
 
 
+bool
+IoPoller_Epoll::requeue(int fd)
+{
+	if ( not m_edge ) return true;
+
+	event_type* pet(m_clients.get(fd));
+	if ( nullptr == pet ) return false;
+
+	// 같은 마스크로 다시 등록하면 커널이 준비 상태를 다시 검사해서 알려준다.
+	struct epoll_event ev;
+	ev.events = toEpollMask(pet->mask);
+	ev.data.ptr = pet;
+
+	if ( epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == -1 )
+	{
+		PWLOGLIB("failed to requeue: fd: %d event: %p mask: %d", fd, pet->event, pet->mask);
+		return false;
+	}
+
+	return true;
+}
+
 bool
 IoPoller_Epoll::orMask(int fd, int mask)
 {
-	event_type& et(m_clients[fd]);
+	event_type* pet(m_clients.get(fd));
+	if ( nullptr == pet )
+	{
+		PWLOGLIB("failed to orMask: not registered: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	event_type& et(*pet);
 	mask |= et.mask;
+	if ( et.mask == mask ) return true;
 
 	struct epoll_event ev;
-	ev.events = mask;
+	ev.events = toEpollMask(mask);
 	ev.data.ptr = &et;
 
 	if ( epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == -1 )
@@ -120,11 +173,19 @@ IoPoller_Epoll::orMask(int fd, int mask)
 bool
 IoPoller_Epoll::andMask(int fd, int mask)
 {
-	event_type& et(m_clients[fd]);
+	event_type* pet(m_clients.get(fd));
+	if ( nullptr == pet )
+	{
+		PWLOGLIB("failed to andMask: not registered: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	event_type& et(*pet);
 	mask &= et.mask;
+	if ( et.mask == mask ) return true;
 
 	struct epoll_event ev;
-	ev.events = mask;
+	ev.events = toEpollMask(mask);
 	ev.data.ptr = &et;
 
 	if ( epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == -1 )
@@ -140,6 +201,7 @@ IoPoller_Epoll::andMask(int fd, int mask)
 ssize_t
 IoPoller_Epoll::dispatch(int timeout_msec)
 {
+	_beginWait();
 	ssize_t ret(epoll_wait(m_epoll, m_events, MAX_EVENT_SIZE, timeout_msec));
 	if ( -1 == ret )
 	{
@@ -147,6 +209,9 @@ IoPoller_Epoll::dispatch(int timeout_msec)
 		return -1;
 	}
 
+	// 대기하는 동안 흐른 시간을 이벤트 처리에 반영한다.
+	_endWait();
+
 	struct epoll_event* ib(m_events);
 	struct epoll_event* ie(m_events+ret);
 	bool del_event(false);
@@ -196,7 +261,7 @@ IoPoller_Epoll::initialize(void)
 	}
 
 	m_epoll = epoll_fd;
-	memset(m_clients, 0x00, sizeof(m_clients));
+	m_clients.clear();
 
 	return true;
 }
@@ -205,7 +270,7 @@ bool
 IoPoller_Epoll::initialize(int efd)
 {
 	m_epoll = efd;
-	memset(m_clients, 0x00, sizeof(m_clients));
+	m_clients.clear();
 	return true;
 }
 
@@ -54,11 +54,13 @@ public:
 	bool setMask(int fd, int mask);
 	bool orMask(int fd, int mask);
 	bool andMask(int fd, int mask);
+	bool requeue(int fd);
 	ssize_t dispatch(int timeout_msec);
-	inline Event* getEvent(int fd) { return ( fd < MAX_EPOLL_SIZE ? m_clients[fd].event : nullptr ); }
+	inline Event* getEvent(int fd) { event_type* et(m_clients.get(fd)); return ( et ? et->event : nullptr ); }
 
 public:
-	const char* getType(void) const { return "epoll"; }
+	const char* getType(void) const { return m_edge ? "epoll_et" : "epoll"; }
+	bool isEdgeTriggered(void) const { return m_edge; }
 
 protected:
 	bool initialize(void);
@@ -68,12 +70,20 @@ public:
 	void destroy(void);
 
 protected:
-	IoPoller_Epoll() : m_epoll(-1) {}
+	explicit IoPoller_Epoll(bool edge = false) : m_epoll(-1), m_edge(edge) {}
 	~IoPoller_Epoll() {}
 
+protected:
+	inline uint32_t toEpollMask(int mask) const
+	{
+		if ( not (mask bitand EDGE) ) return uint32_t(mask);
+		return uint32_t(mask bitand ~EDGE) bitor (m_edge ? uint32_t(EPOLLET) : 0);
+	}
+
 protected:
 	int					m_epoll;
-	event_type			m_clients[MAX_EPOLL_SIZE];
+	bool				m_edge;	//!< EDGE 마스크를 EPOLLET로 등록
+	EventTable			m_clients;
 	struct epoll_event	m_events[MAX_EVENT_SIZE];
 
 friend class IoPoller;
@@ -30,6 +30,7 @@
 
 #include "./pw_iopoller_select.h"
 #include "./pw_log.h"
+#include "./pw_timer.h"
 
 #if defined(HAVE_SELECT)
 namespace pw {
@@ -156,6 +157,7 @@ IoPoller_Select::dispatch(int timeout_msec)
 	fd_set rfds(m_rfds);
 	fd_set wfds(m_wfds);
 
+	_beginWait();
 	ssize_t ret(select(m_max_fd+1, &rfds, &wfds, nullptr, &tv));
 	if ( -1 == ret )
 	{
@@ -163,6 +165,8 @@ IoPoller_Select::dispatch(int timeout_msec)
 		return -1;
 	}
 
+	_endWait();
+
 	int event(0);
 	bool del_event(false);
 
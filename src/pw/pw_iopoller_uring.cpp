@@ -0,0 +1,437 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2015 SK PLANET. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file pw_iopoller_uring.cpp
+ * \brief I/O poller implementation of io_uring(Linux).
+ * \copyright Copyright (c) 2015, SK PLANET. All Rights Reserved.
+ * \license This project is released under the MIT License.
+ */
+
+#include "./pw_iopoller_uring.h"
+#include "./pw_log.h"
+#include "./pw_timer.h"
+
+#ifdef HAVE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace pw {
+
+//! \brief POLL_REMOVE 요청 표시. 완료 이벤트는 무시한다.
+#define PW_URING_REMOVE_TAG	(uint64_t(1) << 63)
+
+static inline int
+_io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+	return int(::syscall(SYS_io_uring_setup, entries, p));
+}
+
+static inline int
+_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, size_t argsz)
+{
+	return int(::syscall(SYS_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+}
+
+static inline uint32_t
+_toPollMask(int mask)
+{
+#ifdef WORDS_BIGENDIAN
+	return (uint32_t(mask) << 16) bitor (uint32_t(mask) >> 16);
+#else
+	return uint32_t(mask);
+#endif
+}
+
+bool
+IoPoller_Uring::add(int fd, Event* client, int mask)
+{
+	if ( -1 == m_ring ) return false;
+	if ( fd < 0 ) return false;
+
+	if ( size_t(fd) >= m_clients.size() ) m_clients.resize(fd+1);
+
+	client_type& ct(m_clients[fd]);
+	if ( ct.event )
+	{
+		PWTRACE("failed to add event: already exists: fd: %d event: %p mask: %d", fd, ct.event, ct.mask);
+		return false;
+	}
+
+	ct.fd = fd;
+	ct.mask = mask;
+	ct.event = client;
+	_arm(fd);
+
+	return true;
+}
+
+bool
+IoPoller_Uring::remove(int fd)
+{
+	if ( -1 == m_ring ) return false;
+	if ( (fd < 0) or (size_t(fd) >= m_clients.size()) ) return false;
+
+	client_type& ct(m_clients[fd]);
+	if ( nullptr == ct.event ) return false;
+
+	_disarm(fd);
+	ct.event = nullptr;
+	ct.fd = -1;
+	ct.mask = 0;
+
+	return true;
+}
+
+bool
+IoPoller_Uring::setMask(int fd, int mask)
+{
+	if ( (fd < 0) or (size_t(fd) >= m_clients.size()) or (nullptr == m_clients[fd].event) )
+	{
+		PWLOGLIB("failed to setMask: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	client_type& ct(m_clients[fd]);
+	if ( ct.armed and (ct.mask == mask) ) return true;
+
+	_disarm(fd);
+	ct.mask = mask;
+	_arm(fd);
+
+	return true;
+}
+
+bool
+IoPoller_Uring::orMask(int fd, int mask)
+{
+	if ( (fd < 0) or (size_t(fd) >= m_clients.size()) )
+	{
+		PWLOGLIB("failed to orMask: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	return this->setMask(fd, m_clients[fd].mask bitor mask);
+}
+
+bool
+IoPoller_Uring::andMask(int fd, int mask)
+{
+	if ( (fd < 0) or (size_t(fd) >= m_clients.size()) )
+	{
+		PWLOGLIB("failed to andMask: fd: %d mask: %d", fd, mask);
+		return false;
+	}
+
+	return this->setMask(fd, m_clients[fd].mask bitand mask);
+}
+
+void
+IoPoller_Uring::_arm(int fd)
+{
+	client_type& ct(m_clients[fd]);
+	ct.gen = (ct.gen + 1) bitand 0x7fffffffU;
+
+	struct io_uring_sqe sqe;
+	memset(&sqe, 0x00, sizeof(sqe));
+	sqe.opcode = IORING_OP_POLL_ADD;
+	sqe.fd = fd;
+	sqe.poll32_events = _toPollMask(ct.mask bitand ~EDGE);
+	sqe.user_data = s_getUserData(fd, ct.gen);
+
+	m_pending.push_back(sqe);
+	ct.pending = m_pending.size();
+	ct.armed = true;
+}
+
+void
+IoPoller_Uring::_disarm(int fd)
+{
+	client_type& ct(m_clients[fd]);
+	if ( not ct.armed ) return;
+
+	const uint64_t ud(s_getUserData(fd, ct.gen));
+
+	// 아직 제출하지 않았으면 요청을 무효로 바꾼다.
+	if ( (ct.pending > 0) and (ct.pending <= m_pending.size()) )
+	{
+		struct io_uring_sqe& sqe(m_pending[ct.pending-1]);
+		if ( (sqe.opcode == IORING_OP_POLL_ADD) and (sqe.user_data == ud) )
+		{
+			sqe.opcode = IORING_OP_NOP;
+			sqe.user_data = PW_URING_REMOVE_TAG;
+			ct.pending = 0;
+			ct.armed = false;
+			return;
+		}
+	}
+
+	struct io_uring_sqe sqe;
+	memset(&sqe, 0x00, sizeof(sqe));
+	sqe.opcode = IORING_OP_POLL_REMOVE;
+	sqe.fd = -1;
+	sqe.addr = ud;
+	sqe.user_data = PW_URING_REMOVE_TAG;
+
+	m_pending.push_back(sqe);
+	ct.pending = 0;
+	ct.armed = false;
+}
+
+bool
+IoPoller_Uring::_submit(int timeout_msec)
+{
+	size_t index(0);
+	const unsigned mask(*m_sq.mask);
+	const unsigned entries(*m_sq.entries);
+
+	do {
+		const unsigned head(__atomic_load_n(m_sq.head, __ATOMIC_ACQUIRE));
+		unsigned tail(*m_sq.tail);
+
+		while ( (index < m_pending.size()) and ((tail - head) < entries) )
+		{
+			const unsigned pos(tail bitand mask);
+			m_sq.sqes[pos] = m_pending[index];
+			m_sq.array[pos] = pos;
+			++tail;
+			++index;
+		}
+
+		__atomic_store_n(m_sq.tail, tail, __ATOMIC_RELEASE);
+
+		const unsigned to_submit(tail - head);
+		const bool last(index == m_pending.size());
+		unsigned flags(0);
+		unsigned min_complete(0);
+		struct __kernel_timespec ts;
+		struct io_uring_getevents_arg arg;
+		memset(&arg, 0x00, sizeof(arg));
+
+		if ( last and (timeout_msec not_eq 0) )
+		{
+			flags = IORING_ENTER_GETEVENTS bitor IORING_ENTER_EXT_ARG;
+			min_complete = 1;
+			if ( timeout_msec > 0 )
+			{
+				ts.tv_sec = timeout_msec / 1000;
+				ts.tv_nsec = (timeout_msec % 1000) * 1000000LL;
+				arg.ts = uint64_t(uintptr_t(&ts));
+			}
+		}
+
+		if ( (0 == to_submit) and (0 == flags) ) break;
+
+		if ( -1 == _io_uring_enter(m_ring, to_submit, min_complete, flags, flags ? &arg : nullptr, flags ? sizeof(arg) : 0) )
+		{
+			if ( (errno == ETIME) or (errno == EINTR) ) break;
+			if ( (errno == EBUSY) or (errno == EAGAIN) )
+			{
+				// 완료 큐가 가득 찼다. 먼저 완료 이벤트를 처리하고 다음에 제출한다.
+				break;
+			}
+
+			PWLOGLIB("io_uring_enter error(%d): %s", errno, strerror(errno));
+			m_pending.erase(m_pending.begin(), m_pending.begin()+index);
+			return false;
+		}
+	} while ( index < m_pending.size() );
+
+	m_pending.erase(m_pending.begin(), m_pending.begin()+index);
+	return true;
+}
+
+ssize_t
+IoPoller_Uring::dispatch(int timeout_msec)
+{
+	if ( -1 == m_ring ) return -1;
+
+	_beginWait();
+	if ( not _submit(timeout_msec) ) return -1;
+
+	_endWait();
+
+	unsigned head(*m_cq.head);
+	const unsigned tail(__atomic_load_n(m_cq.tail, __ATOMIC_ACQUIRE));
+	const unsigned mask(*m_cq.mask);
+	size_t count(0);
+
+	while ( (head not_eq tail) and (count < MAX_EVENT_SIZE) )
+	{
+		m_events[count] = m_cq.cqes[head bitand mask];
+		++head;
+		++count;
+	}
+
+	__atomic_store_n(m_cq.head, head, __ATOMIC_RELEASE);
+
+	ssize_t ret(0);
+	bool del_event(false);
+
+	for ( size_t i(0); i < count; i++ )
+	{
+		const struct io_uring_cqe& cqe(m_events[i]);
+		if ( cqe.user_data bitand PW_URING_REMOVE_TAG ) continue;
+
+		const int fd(int(uint32_t(cqe.user_data)));
+		const uint32_t gen(uint32_t(cqe.user_data >> 32));
+
+		if ( size_t(fd) >= m_clients.size() ) continue;
+
+		client_type& ct(m_clients[fd]);
+		if ( (nullptr == ct.event) or (ct.gen not_eq gen) ) continue;
+
+		ct.armed = false;
+		ct.pending = 0;
+
+		if ( cqe.res < 0 )
+		{
+			PWLOGLIB("io_uring poll error(%d): fd:%d %s", -cqe.res, fd, strerror(-cqe.res));
+			continue;
+		}
+
+		del_event = false;
+		ct.event->eventIo(fd, int(_toPollMask(cqe.res)), del_event);
+		++ret;
+
+		if ( del_event )
+		{
+			this->remove(fd);
+			continue;
+		}
+
+		// 이벤트 처리 중에 테이블이 바뀔 수 있으므로 다시 찾는다.
+		client_type& cur(m_clients[fd]);
+		if ( cur.event and (cur.gen == gen) and (not cur.armed) ) _arm(fd);
+	}
+
+	return ret;
+}
+
+bool
+IoPoller_Uring::initialize(void)
+{
+	struct io_uring_params params;
+	memset(&params, 0x00, sizeof(params));
+
+	int ring(_io_uring_setup(MAX_RING_SIZE, &params));
+	if ( -1 == ring )
+	{
+		PWLOGLIB("failed to initialize io_uring: %s", strerror(errno));
+		return false;
+	}
+
+	do {
+		if ( not (params.features bitand IORING_FEAT_EXT_ARG) )
+		{
+			PWLOGLIB("io_uring does not support IORING_FEAT_EXT_ARG");
+			break;
+		}
+
+		if ( m_ring not_eq -1 ) destroy();
+
+		m_sq.size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		m_cq.size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		const bool single(params.features bitand IORING_FEAT_SINGLE_MMAP);
+		if ( single ) m_sq.size = m_cq.size = std::max(m_sq.size, m_cq.size);
+
+		m_sq.ptr = ::mmap(nullptr, m_sq.size, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+		if ( MAP_FAILED == m_sq.ptr )
+		{
+			m_sq.ptr = nullptr;
+			PWLOGLIB("failed to map io_uring sq: %s", strerror(errno));
+			break;
+		}
+
+		if ( single )
+		{
+			m_cq.ptr = m_sq.ptr;
+		}
+		else
+		{
+			m_cq.ptr = ::mmap(nullptr, m_cq.size, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+			if ( MAP_FAILED == m_cq.ptr )
+			{
+				m_cq.ptr = nullptr;
+				PWLOGLIB("failed to map io_uring cq: %s", strerror(errno));
+				break;
+			}
+		}
+
+		m_sq.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+		void* sqes(::mmap(nullptr, m_sq.sqes_size, PROT_READ bitor PROT_WRITE, MAP_SHARED bitor MAP_POPULATE, ring, IORING_OFF_SQES));
+		if ( MAP_FAILED == sqes )
+		{
+			PWLOGLIB("failed to map io_uring sqes: %s", strerror(errno));
+			break;
+		}
+
+		char* sq((char*)m_sq.ptr);
+		m_sq.head = (unsigned*)(sq + params.sq_off.head);
+		m_sq.tail = (unsigned*)(sq + params.sq_off.tail);
+		m_sq.mask = (unsigned*)(sq + params.sq_off.ring_mask);
+		m_sq.entries = (unsigned*)(sq + params.sq_off.ring_entries);
+		m_sq.array = (unsigned*)(sq + params.sq_off.array);
+		m_sq.sqes = (struct io_uring_sqe*)sqes;
+
+		char* cq((char*)m_cq.ptr);
+		m_cq.head = (unsigned*)(cq + params.cq_off.head);
+		m_cq.tail = (unsigned*)(cq + params.cq_off.tail);
+		m_cq.mask = (unsigned*)(cq + params.cq_off.ring_mask);
+		m_cq.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+		m_ring = ring;
+		m_clients.clear();
+		m_pending.clear();
+
+		return true;
+	} while (false);
+
+	m_ring = ring;
+	destroy();
+
+	return false;
+}
+
+void
+IoPoller_Uring::destroy(void)
+{
+	if ( m_sq.sqes ) ::munmap(m_sq.sqes, m_sq.sqes_size);
+	if ( m_cq.ptr and (m_cq.ptr not_eq m_sq.ptr) ) ::munmap(m_cq.ptr, m_cq.size);
+	if ( m_sq.ptr ) ::munmap(m_sq.ptr, m_sq.size);
+
+	memset(&m_sq, 0x00, sizeof(m_sq));
+	memset(&m_cq, 0x00, sizeof(m_cq));
+
+	if ( m_ring not_eq -1 )
+	{
+		::close(m_ring);
+		m_ring = -1;
+	}
+
+	m_pending.clear();
+}
+
+};//namespace pw;
+#endif//HAVE_IO_URING
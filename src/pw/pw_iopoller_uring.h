@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2015 SK PLANET. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file pw_iopoller_uring.h
+ * \brief I/O poller implementation of io_uring(Linux).
+ * \copyright Copyright (c) 2015, SK PLANET. All Rights Reserved.
+ * \license This project is released under the MIT License.
+ */
+
+#include "./pw_common.h"
+#include "./pw_iopoller.h"
+
+#if defined(HAVE_IO_URING)
+#ifndef __PW_IOPOLLER_URING_H__
+#define __PW_IOPOLLER_URING_H__
+
+#include <linux/io_uring.h>
+
+namespace pw {
+
+//! \brief io_uring 준비 상태(readiness) 폴러.
+//! \details IORING_OP_POLL_ADD로 준비 상태만 감시한다. 마스크 변경은 큐에 쌓아 두었다가
+//!	dispatch에서 기다리기와 함께 한 번에 제출하므로, epoll_ctl처럼 변경할 때마다 시스템콜을 하지 않는다.
+//! \warning 읽기/쓰기를 io_uring으로 제출하지 않는다. 이벤트를 받은 채널이 기존대로
+//!	IoBuffer로 read/write를 직접 하므로, 이벤트마다 있는 읽기/쓰기 시스템콜은 줄지 않는다.
+//!	채널 버퍼는 처리 중에 늘어나거나 옮겨지고 풀로 돌아가기도 하므로,
+//!	커널이 완료할 때까지 영역을 고정하는 구조가 없는 지금은 직접 제출하지 않는다.
+class IoPoller_Uring : public IoPoller
+{
+public:
+	enum
+	{
+		MAX_RING_SIZE = 4096,
+		MAX_EVENT_SIZE = 1024,
+	};
+
+public:
+	bool add(int fd, Event* client, int mask);
+	bool remove(int fd);
+	bool setMask(int fd, int mask);
+	bool orMask(int fd, int mask);
+	bool andMask(int fd, int mask);
+	ssize_t dispatch(int timeout_msec);
+	inline Event* getEvent(int fd) { return ( (fd >= 0) and (size_t(fd) < m_clients.size()) ? m_clients[fd].event : nullptr ); }
+
+public:
+	const char* getType(void) const { return "uring"; }
+
+protected:
+	bool initialize(void);
+
+public:
+	void destroy(void);
+
+protected:
+	//! \brief FD별 등록 정보
+	struct client_type : public event_type
+	{
+		uint32_t	gen;		//!< 세대. 완료 이벤트가 현재 등록과 같은지 확인한다.
+		size_t		pending;	//!< 아직 제출하지 않은 POLL_ADD 위치+1
+		bool		armed;		//!< POLL_ADD 요청 중인지 여부
+
+		inline client_type() : gen(0), pending(0), armed(false) {}
+	};
+
+	//! \brief SQ 링
+	struct sq_type
+	{
+		unsigned*	head;
+		unsigned*	tail;
+		unsigned*	mask;
+		unsigned*	entries;
+		unsigned*	array;
+		struct io_uring_sqe*	sqes;
+		void*		ptr;
+		size_t		size;
+		size_t		sqes_size;
+	};
+
+	//! \brief CQ 링
+	struct cq_type
+	{
+		unsigned*	head;
+		unsigned*	tail;
+		unsigned*	mask;
+		struct io_uring_cqe*	cqes;
+		void*		ptr;
+		size_t		size;
+	};
+
+protected:
+	inline static uint64_t s_getUserData(int fd, uint32_t gen) { return (uint64_t(gen) << 32) bitor uint32_t(fd); }
+	void _arm(int fd);
+	void _disarm(int fd);
+	bool _submit(int timeout_msec);
+
+protected:
+	IoPoller_Uring() : m_ring(-1) { memset(&m_sq, 0x00, sizeof(m_sq)); memset(&m_cq, 0x00, sizeof(m_cq)); }
+	~IoPoller_Uring() { destroy(); }
+
+protected:
+	int							m_ring;
+	sq_type						m_sq;
+	cq_type						m_cq;
+	std::vector<client_type>	m_clients;
+	std::vector<struct io_uring_sqe>	m_pending;	//!< 제출 대기 중인 요청
+	struct io_uring_cqe			m_events[MAX_EVENT_SIZE];
+
+friend class IoPoller;
+};
+
+}; // namespace pw
+
+#endif//!__PW_IOPOLLER_URING_H__
+#endif//HAVE_IO_URING
@@ -34,43 +34,157 @@
 
 namespace pw {
 
-job_key_type
-JobManager::getKey(void)
+//==============================================================================
+// JobAllocator
+JobAllocator::~JobAllocator()
 {
-	job_key_type key(m_key+1);
-	while ( (m_jobs.end() not_eq m_jobs.find(key)) or (0 == key) ) ++key;
-	return (m_key = key);
+	for ( auto chunk : m_chunks ) ::free(chunk);
 }
 
-size_t
-JobManager::dispatchReserve(void)
+void*
+JobAllocator::s_allocate(size_t size)
 {
-	Job* pjob(nullptr);
-	size_t count(0);
-	for ( auto& r : m_reserve )
+	char* block(static_cast<char*>(::operator new(size + HEADER_SIZE)));
+	*reinterpret_cast<JobAllocator**>(block) = nullptr;
+	return block + HEADER_SIZE;
+}
+
+void*
+JobAllocator::allocate(size_t size)
+{
+	const size_t index(s_getClass(size));
+	if ( index >= CLASS_COUNT ) return s_allocate(size);
+
+	block_type*& head(m_free[index]);
+	if ( nullptr == head )
 	{
-		auto ib(m_jobs.find(r.key));
-		if ( ib not_eq m_jobs.end() )
+		// 묶음 하나를 할당하여 빈 블록 목록을 채운다.
+		const size_t block_size(HEADER_SIZE + (index + 1) * CLASS_STEP);
+		char* chunk(static_cast<char*>(::malloc(block_size * CHUNK_BLOCK_COUNT)));
+		if ( nullptr == chunk ) throw std::bad_alloc();
+
+		m_chunks.push_back(chunk);
+		for ( size_t i(CHUNK_BLOCK_COUNT); i > 0; i-- )
 		{
-			++count;
-			pjob = ib->second;
-			bool del_this (true);
-			if ( r.type == reserve_type::PACKET )
-			{
-				pjob->eventReadPacket(ChannelInterface::s_getChannel(r.ch_name), getSafePacketInstance(r.pk.get()), r.param, del_this);
-			}
-			else
-			{
-				pjob->eventError(ChannelInterface::s_getChannel(r.ch_name), r.error.type, r.error.no, del_this);
-			}
-
-			if ( del_this ) delete pjob;
+			block_type* block(reinterpret_cast<block_type*>(chunk + block_size * (i - 1)));
+			block->next = head;
+			head = block;
 		}
+		m_free_count += CHUNK_BLOCK_COUNT;
 	}
 
-	m_reserve.clear();
+	char* block(reinterpret_cast<char*>(head));
+	head = head->next;
+	--m_free_count;
 
-	return count;
+	*reinterpret_cast<JobAllocator**>(block) = this;
+	return block + HEADER_SIZE;
+}
+
+void
+JobAllocator::s_release(void* p, size_t size)
+{
+	if ( nullptr == p ) return;
+
+	char* block(static_cast<char*>(p) - HEADER_SIZE);
+	JobAllocator* alloc(*reinterpret_cast<JobAllocator**>(block));
+	if ( alloc ) alloc->_release(block, size);
+	else ::operator delete(block);
+}
+
+void
+JobAllocator::_release(char* block, size_t size)
+{
+	block_type* b(reinterpret_cast<block_type*>(block));
+	block_type*& head(m_free[s_getClass(size)]);
+	b->next = head;
+	head = b;
+	++m_free_count;
+}
+
+//==============================================================================
+// JobManager
+job_key_type
+JobManager::getKey(void)
+{
+	if ( KEY_NIL == m_free_head )
+	{
+		const size_t old_size(m_slots.size());
+		if ( old_size >= KEY_MAX_SLOT )
+		{
+			PWLOGLIB("too many jobs: %zu", m_count);
+			return 0;
+		}
+
+		const size_t new_size(old_size ? std::min(old_size * 2, size_t(KEY_MAX_SLOT)) : size_t(KEY_MIN_SLOT));
+		m_slots.resize(new_size);
+
+		for ( size_t i(old_size); i < new_size; i++ )
+		{
+			m_slots[i].next = ( (i + 1) < new_size ) ? uint32_t(i + 1) : uint32_t(KEY_NIL);
+		}
+
+		m_free_head = uint32_t(old_size);
+		m_free_tail = uint32_t(new_size - 1);
+	}
+
+	const uint32_t index(m_free_head);
+	slot_type& slot(m_slots[index]);
+	if ( KEY_NIL == (m_free_head = slot.next) ) m_free_tail = KEY_NIL;
+
+	slot.next = KEY_NIL;
+	slot.job = nullptr;
+	++m_count;
+
+	return (slot.gen << KEY_INDEX_BITS) bitor index;
+}
+
+void
+JobManager::_releaseKey(job_key_type key)
+{
+	slot_type* slot(_getSlot(key));
+	if ( nullptr == slot ) return;
+
+	slot->job = nullptr;
+	if ( 0 == (slot->gen = ((slot->gen + 1) bitand KEY_GEN_MASK)) ) slot->gen = 1;
+
+	const uint32_t index(key bitand KEY_INDEX_MASK);
+	if ( KEY_NIL == m_free_tail ) m_free_head = index;
+	else m_slots[m_free_tail].next = index;
+	m_free_tail = index;
+
+	--m_count;
+}
+
+void
+JobManager::_dispatchReserve(reserve_type& r)
+{
+	Job* pjob(find(r.key));
+	if ( nullptr == pjob ) return;
+
+	bool del_this (true);
+	if ( r.type == reserve_type::PACKET )
+	{
+		pjob->eventReadPacket(ChannelInterface::s_getChannel(r.ch_name), getSafePacketInstance(r.pk.get()), r.param, del_this);
+	}
+	else
+	{
+		pjob->eventError(ChannelInterface::s_getChannel(r.ch_name), r.error.type, r.error.no, del_this);
+	}
+
+	if ( del_this ) delete pjob;
+}
+
+bool
+JobManager::setIoPoller(IoPoller* poller)
+{
+	if ( nullptr == poller )
+	{
+		m_reserve.close(true);
+		return true;
+	}
+
+	return m_reserve.open(poller);
 }
 
 size_t
@@ -80,18 +194,12 @@ JobManager::dispatchKill(void)
 	size_t count(0);
 	for ( auto key : m_kills )
 	{
-		auto ib(m_jobs.find(key));
-		if ( ib not_eq m_jobs.end() )
+		if ( nullptr not_eq (pjob = find(key)) )
 		{
-			pjob = ib->second;
-			m_jobs.erase(ib);
-			if ( pjob )
-			{
-				PWTRACE("before DELETE");
-				delete pjob;
-				PWTRACE("after DELETE");
-				++count;
-			}
+			PWTRACE("before DELETE");
+			delete pjob;
+			PWTRACE("after DELETE");
+			++count;
 		}
 	}
 
@@ -116,14 +224,13 @@ JobManager::dispatchPacket(job_key_type key, ChannelInterface* pch, const Packet
 void
 JobManager::reservePacket(job_key_type key, ChannelInterface* pch, std::shared_ptr<PacketInterface> sptr_pk, void* param)
 {
-	std::unique_lock<std::mutex>(m_reserve_lock);
 	reserve_type tmp;
 	tmp.type = reserve_type::PACKET;
 	tmp.key = key;
 	tmp.ch_name = pch?pch->getUniqueName():0;
-	if ( sptr_pk ) tmp.pk = sptr_pk;
+	if ( sptr_pk ) tmp.pk = std::move(sptr_pk);
 	if ( param ) tmp.param = param;
-	this->m_reserve.push_back(tmp);
+	m_reserve.push(std::move(tmp));
 }
 
 bool
@@ -142,42 +249,110 @@ JobManager::dispatchError(job_key_type key, ChannelInterface* pch, ChannelInterf
 void
 JobManager::reserveError(job_key_type key, ChannelInterface* pch, ChannelInterface::Error type, int err)
 {
-	std::unique_lock<std::mutex>(m_reserve_lock);
 	reserve_type tmp;
 	tmp.type = reserve_type::ERROR;
 	tmp.key = key;
 	tmp.ch_name = pch?pch->getUniqueName():0;
 	tmp.error.type = type;
 	tmp.error.no = err;
-	this->m_reserve.push_back(tmp);
+	m_reserve.push(std::move(tmp));
+}
+
+void
+JobManager::_pushQueue(Job* job)
+{
+	// 대부분 가장 늦게 시작한 잡이므로 뒤에서부터 자리를 찾는다.
+	Job* prev(m_queue.tail);
+	while ( prev and (prev->m_start > job->m_start) ) prev = prev->m_prev;
+
+	job->m_prev = prev;
+	job->m_next = prev ? prev->m_next : m_queue.head;
+	if ( job->m_next ) job->m_next->m_prev = job;
+	else m_queue.tail = job;
+	if ( prev ) prev->m_next = job;
+	else m_queue.head = job;
+
+	job->m_index = Job::_Index::QUEUE;
+}
+
+void
+JobManager::_pushDeadline(Job* job, int64_t deadline)
+{
+	job->m_deadline = m_deadlines.insert(job_deadline_cont::value_type(deadline, job));
+	job->m_index = Job::_Index::DEADLINE;
+}
+
+void
+JobManager::_unlinkTimeout(Job* job)
+{
+	switch(job->m_index)
+	{
+	case Job::_Index::QUEUE:
+	{
+		if ( job->m_prev ) job->m_prev->m_next = job->m_next;
+		else m_queue.head = job->m_next;
+		if ( job->m_next ) job->m_next->m_prev = job->m_prev;
+		else m_queue.tail = job->m_prev;
+		job->m_prev = job->m_next = nullptr;
+		break;
+	}
+	case Job::_Index::DEADLINE:
+	{
+		m_deadlines.erase(job->m_deadline);
+		break;
+	}
+	case Job::_Index::NONE: break;
+	}
+
+	job->m_index = Job::_Index::NONE;
+}
+
+void
+JobManager::_setTimeout(Job* job, int64_t timeout)
+{
+	_unlinkTimeout(job);
+
+	if ( (job->m_timeout = timeout) < 0 ) _pushQueue(job);
+	else _pushDeadline(job, job->m_start + timeout);
+}
+
+size_t
+JobManager::_expire(Job* job, int64_t now, int64_t timeout)
+{
+	// 살아남는 잡은 타임아웃만큼 뒤에 다시 검사한다.
+	// 이벤트 처리 중에 잡이 지워질 수 있으므로 미리 옮겨 둔다.
+	_unlinkTimeout(job);
+	_pushDeadline(job, now + (job->m_timeout < 0 ? timeout : job->m_timeout));
+
+	bool del_this(true);
+	job->eventTimeout(now - job->m_start, del_this);
+	if ( del_this ) delete job;
+
+	return 1;
 }
 
 size_t
 JobManager::checkTimeout(int64_t timeout)
 {
 	size_t count(0);
-	Job* pjob(nullptr);
 
 	int64_t now(Timer::s_getNow());
-	bool del_this;
+	if ( timeout < 0 ) timeout = 0;
 
 	dispatchKill();
 	dispatchReserve();
 
-	auto ib(m_jobs.begin()), ie(m_jobs.end());
-	while ( ib not_eq ie )
+	while ( m_queue.head and ((now - m_queue.head->m_start) > timeout) )
 	{
-		pjob = ib->second;
-		++ib;
+		count += _expire(m_queue.head, now, timeout);
+	}
 
-		if ( (now - pjob->m_start) > timeout )
-		{
-			++count;
+	while ( not m_deadlines.empty() )
+	{
+		auto ib(m_deadlines.begin());
+		if ( ib->first >= now ) break;
 
-			del_this = true;
-			pjob->eventTimeout(now - pjob->m_start, del_this);
-			if ( del_this ) delete pjob;
-		}
+		count += _expire(ib->second, now, timeout);
 	}
 
 	return count;
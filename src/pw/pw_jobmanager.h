@@ -32,6 +32,7 @@
 #include "./pw_packet_if.h"
 #include "./pw_channel_if.h"
 #include "./pw_timer.h"
+#include "./pw_notifier.h"
 
 #ifndef __PW_JOBMANAGER_H__
 #define __PW_JOBMANAGER_H__
@@ -39,8 +40,63 @@
 namespace pw {
 
 class JobManager;
+class Job;
 
 using job_key_type = uint32_t;
+using job_deadline_cont = std::multimap<int64_t, Job*>;
+
+//! \brief 잡 메모리 풀.
+//! \details 크기 등급별로 블록을 묶음(chunk) 단위로 할당하고, 반환한 블록은 다시 사용한다.
+//!	블록 앞에 할당한 풀을 기록하므로, 어디서 할당했든 Job::operator delete로 반환할 수 있다.
+class JobAllocator final
+{
+public:
+	enum
+	{
+		HEADER_SIZE = 16,	//!< 블록 머리. 할당한 풀 주소를 기록한다.
+		CLASS_STEP = 64,
+		CLASS_COUNT = 16,	//!< 1 KiB까지 풀에서 할당한다. 더 크면 힙에서 할당한다.
+		CHUNK_BLOCK_COUNT = 64,	//!< 묶음당 블록 수
+	};
+
+public:
+	//! \brief 블록 할당. 반환한 주소 앞에 머리가 있다.
+	void* allocate(size_t size);
+
+	//! \brief 풀을 거치지 않고 힙에서 할당한다.
+	static void* s_allocate(size_t size);
+
+	//! \brief 블록 반환. 할당한 풀을 찾아 돌려준다.
+	static void s_release(void* p, size_t size);
+
+	//! \brief 보관 중인 블록 수
+	inline size_t getFreeCount(void) const { return m_free_count; }
+
+	//! \brief 할당한 묶음 수
+	inline size_t getChunkCount(void) const { return m_chunks.size(); }
+
+public:
+	JobAllocator() = default;
+	~JobAllocator();
+
+	JobAllocator(const JobAllocator&) = delete;
+	JobAllocator& operator = (const JobAllocator&) = delete;
+
+private:
+	struct block_type
+	{
+		block_type*	next;
+	};
+
+private:
+	inline static size_t s_getClass(size_t size) { return (size + CLASS_STEP - 1) / CLASS_STEP - 1; }
+	void _release(char* block, size_t size);
+
+private:
+	block_type*	m_free[CLASS_COUNT] {};
+	std::vector<char*>	m_chunks;
+	size_t	m_free_count { 0 };
+};
 
 //! \brief 트랜젝션 처리
 class Job
@@ -65,14 +121,27 @@ public:
 	//! \brief 잡 시작 시간
 	inline int64_t getStart(void) const { return m_start; }
 
-	//! \brief 걸린 시간
-	inline int64_t getDiff(void) const { return (Timer::s_getNowMicro() - m_start); }
+	//! \brief 걸린 시간(ms)
+	inline int64_t getDiff(void) const { return (Timer::s_getNow() - m_start); }
 
 	//! \brief 잡 키
 	inline job_key_type getKey(void) const { return m_key; }
 
 	inline void setRelease(void);
 
+public:
+	//! \brief JobManager::create로 만들면 잡 매니저의 풀에서, new로 만들면 힙에서 할당한다.
+	//! \warning 상속 클래스에서 operator new/delete를 재정의하지 않는다.
+	inline static void* operator new(size_t size) { return JobAllocator::s_allocate(size); }
+	inline static void operator delete(void* p, size_t size) { JobAllocator::s_release(p, size); }
+
+	//! \brief 잡별 타임아웃을 설정한다.
+	//! \param[in] timeout 시작 시간부터의 타임아웃(ms). 음수면 매니저 기본값을 사용한다.
+	inline void setTimeout(int64_t timeout);
+
+	//! \brief 잡별 타임아웃. 음수면 매니저 기본값을 사용한다.
+	inline int64_t getTimeout(void) const { return m_timeout; }
+
 protected:
 	//! \brief 패킷을 받았을 경우, 잡 매니저에 의해 호출
 	//! \param[inout] pch 채널.
@@ -92,11 +161,26 @@ protected:
 	//! \param[out] del_this true일 경우, 잡 매니저가 delete를 호출한다.
 	virtual void eventError(ChannelInterface* pch, ChannelInterface::Error type, int err, bool& del_this) { del_this = true; }
 
+private:
+	//! \brief 타임아웃 검사 목록
+	enum class _Index : uint8_t
+	{
+		NONE,
+		QUEUE,	//!< 매니저 기본값. 시작 순서 목록
+		DEADLINE,	//!< 만료 시각 순서 목록
+	};
+
 private:
 	JobManager& m_man;		//!< 매니저
 	const int64_t m_start;	//!< 시작시간 (ms)
 	const job_key_type m_key;		//!< 키
 
+	int64_t m_timeout { -1 };	//!< 잡별 타임아웃 (ms)
+	_Index m_index { _Index::NONE };
+	Job* m_prev { nullptr };	//!< 시작 순서 목록 이전 잡
+	Job* m_next { nullptr };	//!< 시작 순서 목록 다음 잡
+	job_deadline_cont::iterator m_deadline;	//!< 만료 시각 목록 위치
+
 protected:
 	inline virtual ~Job();
 
@@ -109,38 +193,116 @@ class JobManager final
 public:
 	using Job = pw::Job;
 
+public:
+	explicit JobManager() : m_reserve(*this) {}
+	~JobManager() = default;
+
+	JobManager(const JobManager&) = delete;
+	JobManager& operator = (const JobManager&) = delete;
+
 public:
 	//! \brief 해당 잡에 패킷을 넘긴다.
 	bool dispatchPacket(job_key_type key, ChannelInterface* pch, const PacketInterface& pk, void* param = nullptr);
+
+	//! \brief 다른 스레드에서 잡에 패킷을 넘긴다.
+	//! \details 폴러 스레드에서 dispatchPacket과 같이 처리한다. 스레드에 안전하다.
 	void reservePacket(job_key_type key, ChannelInterface* pch, std::shared_ptr<PacketInterface> sptr_pk, void* param = nullptr);
 
 	//! \brief 채널 에러에 대한 이벤트를 넘긴다.
 	bool dispatchError(job_key_type key, ChannelInterface* pch, ChannelInterface::Error type, int err);
+
+	//! \brief 다른 스레드에서 채널 에러에 대한 이벤트를 넘긴다. 스레드에 안전하다.
 	void reserveError(job_key_type key, ChannelInterface* pch, ChannelInterface::Error type, int err);
 
+	//! \brief 예약한 이벤트를 바로 처리하도록 폴러를 설정한다.
+	//! \details 설정하지 않으면 checkTimeout에서 처리한다.
+	//! \param[in] poller nullptr이면 해제한다.
+	bool setIoPoller(IoPoller* poller);
+
+	//! \brief fork 후 자식에서 폴러를 건드리지 않고 알림을 닫는다.
+	inline void clearIoPoller(void) { m_reserve.close(false); }
+
 	//! \brief 타임아웃이 발생한 잡을 처리한다.
 	//!	InstanceInterface 상속 객체의 eventTimer에서 호출하는 것이 좋다.
+	//! \details 기본 타임아웃 잡은 시작 순서로, 잡별 타임아웃 잡은 만료 시각 순서로 관리하므로
+	//!	만료된 잡만 검사한다. eventTimeout에서 지우지 않은 잡은 타임아웃만큼 뒤에 다시 호출된다.
 	//! \param[in] timeout 타임아웃 시간(단위: ms)
 	size_t checkTimeout(int64_t timeout);
 
+	//! \brief 잡 매니저의 풀에서 잡을 만든다.
+	//! \details 다른 잡과 같이 delete로 지우거나 del_this로 반환하면 풀로 돌아간다.
+	template<typename _Type, typename... _Args>
+	_Type* create(_Args&&... args)
+	{
+		void* p(m_alloc.allocate(sizeof(_Type)));
+		try {
+			return ::new (p) _Type(std::forward<_Args>(args)...);
+		} catch (...) {
+			JobAllocator::s_release(p, sizeof(_Type));
+			throw;
+		}
+	}
+
 	//! \brief 잡을 찾는다.
-	inline Job* find(job_key_type key) { auto ib(m_jobs.find(key)); return m_jobs.end() == ib ? nullptr : ib->second; }
+	inline Job* find(job_key_type key) { slot_type* slot(_getSlot(key)); return slot ? slot->job : nullptr; }
 
 	//! \brief 관리 잡 개수를 반환한다.
-	inline size_t size(void) const { return m_jobs.size(); }
+	inline size_t size(void) const { return m_count; }
+
+	//! \brief 잡 메모리 풀
+	inline const JobAllocator& getAllocator(void) const { return m_alloc; }
+
+private:
+	//! \brief 잡 키. 아래 비트는 슬롯 번호, 위 비트는 슬롯 세대이다.
+	//! 슬롯을 다시 사용하면 세대가 바뀌므로 지워진 잡의 키로는 찾을 수 없다.
+	enum : uint32_t
+	{
+		KEY_INDEX_BITS = 22,
+		KEY_INDEX_MASK = ((1U << KEY_INDEX_BITS) - 1),
+		KEY_GEN_MASK = ((1U << (32 - KEY_INDEX_BITS)) - 1),
+		KEY_MAX_SLOT = (1U << KEY_INDEX_BITS),	//!< 최대 잡 개수
+		KEY_NIL = 0xffffffffU,
+		KEY_MIN_SLOT = 64,
+	};
+
+	struct slot_type
+	{
+		Job*		job { nullptr };
+		uint32_t	gen { 1 };	//!< 세대. 0은 사용하지 않으므로 키가 0이 되지 않는다.
+		uint32_t	next { KEY_NIL };	//!< 빈 슬롯 목록 다음 슬롯
+	};
+
+	using slot_cont = std::vector<slot_type>;
 
 private:
-	//! \brief 키를 발급한다.
+	//! \brief 키를 발급한다. 실패하면 0을 반환한다.
 	job_key_type getKey(void);
 	size_t dispatchKill(void);
-	size_t dispatchReserve(void);
+	inline size_t dispatchReserve(void) { return m_reserve.dispatch(); }
 
-	inline void add(Job* job) { m_jobs[job->m_key] = job; }
+	inline slot_type* _getSlot(job_key_type key)
+	{
+		const uint32_t index(key bitand KEY_INDEX_MASK);
+		if ( index >= m_slots.size() ) return nullptr;
+
+		slot_type& slot(m_slots[index]);
+		return ( slot.gen == (key >> KEY_INDEX_BITS) ) ? &slot : nullptr;
+	}
+
+	//! \brief 키를 반환한다. 슬롯 세대를 올려 빈 슬롯 목록 끝에 넣는다.
+	void _releaseKey(job_key_type key);
+
+	inline void add(Job* job) { slot_type* slot(_getSlot(job->m_key)); if ( slot ) slot->job = job; }
 	inline void remove(Job* job) { m_kills.insert(job->m_key); }
 	inline void remove(job_key_type key) { m_kills.insert(key); }
 
+	void _pushQueue(Job* job);
+	void _pushDeadline(Job* job, int64_t deadline);
+	void _unlinkTimeout(Job* job);
+	void _setTimeout(Job* job, int64_t timeout);
+	size_t _expire(Job* job, int64_t now, int64_t timeout);
+
 private:
-	using job_cont = std::unordered_map<job_key_type, Job*>;
 	using kill_cont = std::unordered_set<job_key_type>;
 
 
@@ -156,27 +318,52 @@ private:
 		} error;
 	};
 
-	using reserve_cont = std::list<reserve_type>;
+	//! \brief 예약 큐. 폴러 스레드에서 잡에 넘긴다.
+	class _ReserveQueue final : public PollerQueueTemplate<reserve_type>
+	{
+	public:
+		explicit _ReserveQueue(JobManager& man) : m_man(man) {}
+		virtual ~_ReserveQueue() = default;
+
+	private:
+		void eventQueue(reserve_type& r) override { m_man._dispatchReserve(r); }
+
+	private:
+		JobManager&	m_man;
+	};
+
+private:
+	void _dispatchReserve(reserve_type& r);
 
 private:
-	job_cont m_jobs;
+	JobAllocator m_alloc;
+	slot_cont m_slots;
+	uint32_t m_free_head { KEY_NIL };	//!< 빈 슬롯 목록. 오래 비어 있던 슬롯부터 사용한다.
+	uint32_t m_free_tail { KEY_NIL };
+	size_t m_count { 0 };
 	kill_cont m_kills;
-	job_key_type m_key;
 
-	std::mutex m_reserve_lock;
-	reserve_cont m_reserve;
+	struct {
+		Job* head { nullptr };
+		Job* tail { nullptr };
+	} m_queue;	//!< 기본 타임아웃 잡. 시작 순서
+	job_deadline_cont m_deadlines;	//!< 잡별 타임아웃 잡. 만료 시각 순서
+
+	_ReserveQueue m_reserve;
 
 friend class pw::Job;
 };
 
 Job::Job(JobManager& man) : m_man(man), m_start(Timer::s_getNow()), m_key(man.getKey())
 {
-	m_man.m_jobs[m_key] = this;
+	m_man.add(this);
+	m_man._pushQueue(this);
 }
 
 Job::~Job()
 {
-	m_man.m_jobs.erase(this->m_key);
+	m_man._unlinkTimeout(this);
+	m_man._releaseKey(this->m_key);
 }
 
 void
@@ -185,6 +372,12 @@ Job::setRelease ( void )
 	m_man.m_kills.insert(m_key);
 }
 
+void
+Job::setTimeout ( int64_t timeout )
+{
+	m_man._setTimeout(this, timeout);
+}
+
 
 };
 
@@ -34,6 +34,9 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+#	include <linux/filter.h>
+#endif
 
 namespace pw {
 
@@ -151,6 +154,8 @@ private:
 	bool	m_succ;
 };
 
+static size_t s_accept_budget(ListenerInterface::DEFAULT_ACCEPT_BUDGET);
+
 ListenerInterface::ListenerInterface(IoPoller* poller) : Socket(-1, poller), m_auto_async(true), m_ssl_ctx(nullptr)
 {
 	PWTRACE("new listener: %p pid:%d", this, int(::getpid()));
@@ -218,15 +223,9 @@ ListenerInterface::close(void)
 	}
 }
 
-bool
-ListenerInterface::open(const SocketAddress& sa, int socktype, int protocol)
+int
+ListenerInterface::s_listen(const SocketAddress& sa, int socktype, int protocol, bool reuseport)
 {
-	if ( m_fd >= 0 )
-	{
-		PWLOGLIB("already fd:%d", m_fd);
-		return false;
-	}
-
 	int fd(-1);
 	const char* errpos(nullptr);
 	do {
@@ -243,6 +242,21 @@ ListenerInterface::open(const SocketAddress& sa, int socktype, int protocol)
 			break;
 		}
 
+		if ( reuseport )
+		{
+#ifdef SO_REUSEPORT
+			if ( -1 == ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) )
+			{
+				errpos = "setsockopt::REUSEPORT";
+				break;
+			}
+#else
+			errno = ENOPROTOOPT;
+			errpos = "setsockopt::REUSEPORT";
+			break;
+#endif
+		}
+
 		if ( -1 == ::bind(fd, (struct sockaddr*)sa.getData(), sa.getSize()) )
 		{
 			errpos = "bind";
@@ -257,45 +271,128 @@ ListenerInterface::open(const SocketAddress& sa, int socktype, int protocol)
 
 		s_setNonBlocking(fd);
 
-		m_fd = fd;
-		if ( m_poller ) m_poller->add(fd, this, POLLIN);
-
 		char _host[SocketAddress::MAX_HOST_SIZE] = "unknown";
 		char _service[SocketAddress::MAX_SERVICE_SIZE] = "unknown";
 
 		sa.getName(_host, sizeof(_host), _service, sizeof(_service));
-		PWLOGLIB("new listener: host:%s service:%s fd:%d family:%d socktype:%d protocol:%d", _host, _service, m_fd, sa.getFamily(), socktype, protocol);
+		PWLOGLIB("new listener: host:%s service:%s fd:%d family:%d socktype:%d protocol:%d reuseport:%d", _host, _service, fd, sa.getFamily(), socktype, protocol, int(reuseport));
 
-		return true;
+		return fd;
 	} while (false);
 
 	PWLOGLIB("failed to %s(%d): port:%d fd:%d family:%d socktype:%d protocol:%d %s", errpos, errno, sa.getPort(), fd, sa.getFamily(), socktype, protocol, strerror(errno));
+	if ( -1 not_eq fd ) ::close(fd);
+
+	return -1;
+}
 
+bool
+ListenerInterface::s_attachReusePortCPU(int fd, size_t count)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+	if ( 0 == count ) return false;
+
+	// A = cpu; A %= count; return A
+	struct sock_filter code[] = {
+		{ BPF_LD bitor BPF_W bitor BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU) },
+		{ BPF_ALU bitor BPF_MOD bitor BPF_K, 0, 0, uint32_t(count) },
+		{ BPF_RET bitor BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog prog;
+	prog.len = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+
+	if ( -1 == ::setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) )
+	{
+		PWLOGLIB("failed to attach reuseport cbpf(%d): fd:%d count:%zu %s", errno, fd, count, strerror(errno));
+		return false;
+	}
+
+	return true;
+#else
+	PWLOGLIB("not supported reuseport cbpf: fd:%d count:%zu", fd, count);
 	return false;
+#endif
 }
 
 void
-ListenerInterface::eventIo(int fd, int event, bool& del_event)
+ListenerInterface::s_setAcceptBudget(size_t budget)
+{
+	s_accept_budget = std::max(budget, size_t(1));
+}
+
+size_t
+ListenerInterface::s_getAcceptBudget(void)
 {
-	accept_type param;
-	param.lsnr = this;
+	return s_accept_budget;
+}
 
+int
+ListenerInterface::acceptClient(SocketAddress* sa)
+{
 	socklen_t slen(SocketAddress::MAX_STORAGE_SIZE);
-	SocketAddress& sa(param.sa);
-	int& cfd(param.fd);
+	struct sockaddr* addr( sa ? (struct sockaddr*)sa->getData() : nullptr );
+	socklen_t* paddrlen( sa ? &slen : nullptr );
 
-	if ( -1 == (cfd = ::accept(m_fd, (struct sockaddr*)sa.getData(), &slen)) )
+	int cfd(-1);
+	do {
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+		cfd = ::accept4(m_fd, addr, paddrlen, SOCK_CLOEXEC bitor (m_auto_async ? SOCK_NONBLOCK : 0));
+#else
+		if ( (-1 not_eq (cfd = ::accept(m_fd, addr, paddrlen))) and m_auto_async ) Socket::s_setNonBlocking(cfd);
+#endif
+	} while ( (-1 == cfd) and ((EINTR == errno) or (ECONNABORTED == errno)) );
+
+	if ( -1 == cfd )
 	{
-		PWLOGLIB("failed to accept new client(%d): fd:%d %s", errno, m_fd, strerror(errno));
-		return;
+		if ( (EAGAIN not_eq errno) and (EWOULDBLOCK not_eq errno) )
+		{
+			PWLOGLIB("failed to accept new client(%d): pid:%d fd:%d %s", errno, int(::getpid()), m_fd, strerror(errno));
+		}
+		return -1;
 	}
 
-	if ( m_auto_async )
+	if ( sa ) sa->recalculateSize();
+	return cfd;
+}
+
+bool
+ListenerInterface::open(const SocketAddress& sa, int socktype, int protocol)
+{
+	if ( m_fd >= 0 )
 	{
-		Socket::s_setNonBlocking(cfd);
+		PWLOGLIB("already fd:%d", m_fd);
+		return false;
 	}
 
-	sa.recalculateSize();
+	const int fd(s_listen(sa, socktype, protocol));
+	if ( -1 == fd ) return false;
+
+	m_fd = fd;
+	if ( m_poller ) m_poller->add(fd, this, POLLIN);
+
+	return true;
+}
+
+void
+ListenerInterface::eventIo(int fd, int event, bool& del_event)
+{
+	// 접속이 몰리면 이벤트 한 번에 여러 개를 받는다.
+	const size_t budget(s_getAcceptBudget());
+	for ( size_t i(0); (i < budget) and (-1 not_eq m_fd); i++ )
+	{
+		accept_type param;
+		param.lsnr = this;
+		if ( -1 == (param.fd = acceptClient(&param.sa)) ) break;
+
+		_dispatchAccept(param);
+	}
+}
+
+void
+ListenerInterface::_dispatchAccept(accept_type& param)
+{
+	int& cfd(param.fd);
 
 	do {
 		if ( m_ssl_ctx )
@@ -349,13 +446,10 @@ ParentListener::~ParentListener()
 int
 ParentListener::getPipeFD(void) const
 {
-	static size_t index(-1);
 	//if ( not InstanceInterface::m_inst ) return -1;
 	InstanceInterface& inst(*InstanceInterface::s_inst);
-	size_t child_count(inst.getChildCount());
-	if ( 0 == child_count ) return -1;
-	index = (index + 1) % child_count;
-	InstanceInterface::child_type* ct(inst.getChildByIndex(index));
+	m_index = inst.selectChild();
+	InstanceInterface::child_type* ct(inst.getChildByIndex(m_index));
 	if ( not ct ) return -1;
 	return (ct->getFDByParent());
 }
@@ -364,51 +458,87 @@ void
 ParentListener::eventIo(int fd, int event, bool& del_event)
 {
 	PWTRACE("ParentListener::eventIo this:%p fd:%d event:%d pid:%d ppid:%d",  this, fd, event, int(::getpid()), int(::getppid()));
-	accept_type param;
-	param.lsnr = this;
 
-	socklen_t slen(SocketAddress::MAX_STORAGE_SIZE);
-	SocketAddress& sa(param.sa);
-	int& cfd(param.fd);
+	// 받은 접속을 모아 두었다가 차일드마다 한 번의 sendmsg로 넘긴다.
+	accept_type params[Socket::MAX_MESSAGE_FD];
+	size_t count(0);
 
-	if ( -1 == (cfd = ::accept(m_fd, (struct sockaddr*)sa.getData(), &slen)) )
+	const size_t budget(s_getAcceptBudget());
+	for ( size_t i(0); (i < budget) and (-1 not_eq m_fd); i++ )
 	{
-		PWLOGLIB("failed to accept new client(%d): pid:%d fd:%d %s", errno, int(::getpid()), m_fd, strerror(errno));
-		return;
+		accept_type& param(params[count]);
+		param.lsnr = this;
+		if ( -1 == (param.fd = acceptClient(&param.sa)) ) break;
+
+		if ( ++count == Socket::MAX_MESSAGE_FD )
+		{
+			_sendToChild(params, count);
+			count = 0;
+		}
 	}
 
-	if ( m_auto_async )
+	if ( count > 0 ) _sendToChild(params, count);
+}
+
+void
+ParentListener::_sendToChild(accept_type* params, size_t count)
+{
+	InstanceInterface& inst(*InstanceInterface::s_inst);
+
+	int pipe_fds[Socket::MAX_MESSAGE_FD];
+	size_t indexes[Socket::MAX_MESSAGE_FD];
+	bool sent[Socket::MAX_MESSAGE_FD];
+	for ( size_t i(0); i < count; i++ )
 	{
-		Socket::s_setNonBlocking(cfd);
+		m_index = size_t(-1);
+		pipe_fds[i] = getPipeFD();
+		indexes[i] = m_index;
+		sent[i] = false;
 	}
 
-	sa.recalculateSize();
-	int pipe_fd(getPipeFD());
+	int fds[Socket::MAX_MESSAGE_FD];
+	int types[Socket::MAX_MESSAGE_FD];
+	size_t members[Socket::MAX_MESSAGE_FD];
+	for ( size_t i(0); i < count; i++ )
+	{
+		if ( sent[i] ) continue;
 
-	do {
-		if ( -1 == pipe_fd )
+		// 같은 차일드로 가는 접속을 모은다.
+		size_t n(0);
+		for ( size_t j(i); j < count; j++ )
 		{
-			PWLOGLIB("failed to get pipe fd");
-			break;
+			if ( sent[j] or (pipe_fds[j] not_eq pipe_fds[i]) ) continue;
+			sent[j] = true;
+			members[n] = j;
+			fds[n] = params[j].fd;
+			types[n] = m_type;
+			++n;
 		}
 
-		if ( sizeof(m_type) not_eq Socket::s_sendMessage(pipe_fd, cfd, (char*)&m_type, sizeof(m_type)) )
+		bool succ(false);
+		if ( -1 == pipe_fds[i] )
 		{
-			PWLOGLIB("failed to send fd to child process");
-			break;
+			PWLOGLIB("failed to get pipe fd");
 		}
+		else if ( ssize_t(sizeof(int) * n) not_eq Socket::s_sendMessage(pipe_fds[i], fds, n, (char*)types, sizeof(int) * n) )
+		{
+			PWLOGLIB("failed to send fd to child process: count:%zu", n);
+		}
+		else succ = true;
 
-		if ( not eventAccept(param) ) break;
-
-		// 차일드로 넘어간 FD에 대해선 ::close를 호출해야한다.
-		// 그래야 차일드에서 ::close를 호출 할 때 비로소 리소스가 정리 될테니
-		// 2013-05-21 LYB
-		::close(cfd);
-
-		return;
-	} while(false);
-
-	::close(cfd);
+		for ( size_t k(0); k < n; k++ )
+		{
+			accept_type& param(params[members[k]]);
+			if ( succ ) eventAccept(param);
+			else inst.releaseChild(indexes[members[k]]);
+
+			// 차일드로 넘어간 FD에 대해선 ::close를 호출해야한다.
+			// 그래야 차일드에서 ::close를 호출 할 때 비로소 리소스가 정리 될테니
+			// 2013-05-21 LYB
+			::close(param.fd);
+			param.fd = -1;
+		}
+	}
 }
 
 ChildListenerInterface::ChildListenerInterface(IoPoller* poller) : ListenerInterface(poller)
@@ -440,6 +570,25 @@ ChildListenerInterface::open(int pipe_fd)
 	}
 
 	m_fd = pipe_fd;
+	m_type = LT_NONE;
+
+	return true;
+}
+
+bool
+ChildListenerInterface::openReusePort(int lsnr_fd, int type)
+{
+	if ( m_fd not_eq -1 ) close();
+
+	if ( not m_poller->add(lsnr_fd, this, POLLIN) )
+	{
+		PWLOGLIB("failed to open reuseport child listener. register poll-in. pid:%d fd:%d", int(::getpid()), lsnr_fd);
+		::close(lsnr_fd);
+		return false;
+	}
+
+	m_fd = lsnr_fd;
+	m_type = type;
 
 	return true;
 }
@@ -455,26 +604,65 @@ ChildListenerInterface::getPipeFD(void) const
 void
 ChildListenerInterface::eventIo(int fd, int event, bool& del_this)
 {
-	accept_type param;
-	param.lsnr = this;
+	if ( isReusePort() )
+	{
+		const size_t budget(s_getAcceptBudget());
+		for ( size_t i(0); (i < budget) and (-1 not_eq m_fd); i++ )
+		{
+			accept_type param;
+			param.lsnr = this;
+			if ( -1 == (param.fd = acceptClient(&param.sa)) ) break;
 
-	const int pipe_fd(getPipeFD());
-	int& cfd(param.fd);
-	int type(LT_NONE);
-	if ( sizeof(type) not_eq Socket::s_receiveMessage(pipe_fd, cfd, (char*)&type, sizeof(type)) )
+			param.type = static_cast<listener_type>(m_type);
+			_dispatchAccept(param);
+		}
+		return;
+	}
+
+	// 부모가 한 번에 넘긴 접속을 모두 받는다.
+	int fds[Socket::MAX_MESSAGE_FD];
+	int types[Socket::MAX_MESSAGE_FD];
+	size_t count(Socket::MAX_MESSAGE_FD);
+	const ssize_t res(Socket::s_receiveMessage(getPipeFD(), fds, count, (char*)types, sizeof(types)));
+	if ( res < 0 )
 	{
 		PWLOGLIB("failed to get fd from socket pair");
 		return;
 	}
 
-	if ( m_auto_async )
+	auto& inst(*InstanceInterface::s_inst);
+	const size_t type_count(size_t(res) / sizeof(int));
+	for ( size_t i(0); i < count; i++ )
 	{
-		Socket::s_setNonBlocking(cfd);
+		// 부모가 selectChild에서 늘린 대기 접속 개수를 돌려준다.
+		inst.releaseChild(inst.getChildIndex());
+
+		if ( i >= type_count )
+		{
+			PWLOGLIB("no listener type for fd: fd:%d index:%zu types:%zu", fds[i], i, type_count);
+			::close(fds[i]);
+			continue;
+		}
+
+		accept_type param;
+		param.lsnr = this;
+		param.fd = fds[i];
+
+		if ( m_auto_async )
+		{
+			Socket::s_setNonBlocking(param.fd);
+		}
+
+		param.sa.assignByPeer(param.fd);
+		param.type = static_cast<listener_type>(types[i]);
+		_dispatchAccept(param);
 	}
+}
 
-	SocketAddress& sa(param.sa);
-	sa.assignByPeer(cfd);
-	param.type = static_cast<listener_type>(type);
+void
+ChildListenerInterface::_dispatchAccept(accept_type& param)
+{
+	int& cfd(param.fd);
 
 	do {
 		if ( not eventSetParameters(param) )
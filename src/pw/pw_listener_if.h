@@ -73,6 +73,11 @@ public:
 		std::ostream& dump(std::ostream& os) const;
 	};
 
+	enum
+	{
+		DEFAULT_ACCEPT_BUDGET = 64,	//!< 이벤트 한 번에 받는 기본 최대 접속 개수
+	};
+
 public:
 	explicit ListenerInterface(IoPoller* poller);
 	virtual ~ListenerInterface();
@@ -106,6 +111,32 @@ public:
 	//! \brief 리스너 폐쇄
 	void close(void);
 
+public:
+	//! \brief 리슨 소켓을 만든다.
+	//! \param[in] reuseport SO_REUSEPORT를 설정한다. 같은 포트에 여러 소켓을 열어 커널이 접속을 나누게 한다.
+	//! \return 실패하면 -1을 반환한다.
+	static int s_listen(const SocketAddress& sa, int socktype = SOCK_STREAM, int protocol = 0, bool reuseport = false);
+
+	//! \brief SO_REUSEPORT 그룹에 접속을 받은 CPU 번호로 소켓을 고르는 CBPF 프로그램을 붙인다.
+	//! \details 그룹의 소켓 순서는 bind한 순서이며, CPU 번호를 count로 나눈 나머지 번째 소켓을 고른다.
+	//! \param[in] fd 그룹에 속한 아무 소켓
+	//! \param[in] count 그룹의 소켓 개수
+	static bool s_attachReusePortCPU(int fd, size_t count);
+
+	//! \brief 이벤트 한 번에 받을 최대 접속 개수를 설정한다. 0이면 1로 본다.
+	//! \details 접속이 몰릴 때 루프 한 턴에 하나씩만 받지 않도록 한다. 다른 이벤트가 밀리지 않을 만큼 정한다.
+	static void s_setAcceptBudget(size_t budget);
+
+	//! \brief 이벤트 한 번에 받을 최대 접속 개수
+	static size_t s_getAcceptBudget(void);
+
+protected:
+	//! \brief 접속을 하나 받는다.
+	//! \details accept4로 CLOEXEC와 자동 Async 모드를 함께 설정한다. EINTR, ECONNABORTED는 다시 시도한다.
+	//! \param[out] sa 접속한 주소. nullptr이면 받지 않는다.
+	//! \return 더 받을 접속이 없거나 실패하면 -1을 반환한다.
+	int acceptClient(SocketAddress* sa);
+
 protected:
 	//! \brief 새로운 접속을 받아 eventAccept하기 전에 설정할 파라매터 처리.
 	//	자식 리스너에서 SSL 생성할 때 사용한다.
@@ -120,6 +151,9 @@ protected:
 protected:
 	bool			m_auto_async;	//!< 자동 Async모드 소켓 전환
 
+private:
+	void _dispatchAccept(accept_type& param);
+
 private:
 	SslContext*	m_ssl_ctx;
 
@@ -146,8 +180,13 @@ protected:
 	//! \warning 딱히 상속 받을 필요는 없다.
 	inline bool eventAccept(const accept_type&) { return false; }
 
+private:
+	//! \brief 받은 접속을 차일드별로 모아 한 번에 넘기고, 부모 쪽 FD를 닫는다.
+	void _sendToChild(accept_type* params, size_t count);
+
 private:
 	int		m_type;
+	mutable size_t	m_index{size_t(-1)};	//!< getPipeFD에서 고른 차일드 인덱스
 };
 
 //! \brief 멀티세션 모드에서 자식 프로세스 용 리스너.
@@ -157,6 +196,14 @@ class ChildListenerInterface : public ListenerInterface
 public:
 	bool open(int pipe_fd = -1);
 
+	//! \brief 부모가 만든 SO_REUSEPORT 리슨 소켓에서 직접 접속을 받는다.
+	//! \param[in] lsnr_fd 리슨 소켓. 실패해도 소유권을 가져가서 닫는다.
+	//! \param[in] type eventAccept에 넘길 리스너 타입
+	bool openReusePort(int lsnr_fd, int type);
+
+	//! \brief SO_REUSEPORT 소켓으로 접속을 받는지 여부
+	inline bool isReusePort(void) const { return LT_NONE not_eq m_type; }
+
 public:
 	explicit ChildListenerInterface(IoPoller* poller);
 	virtual ~ChildListenerInterface();
@@ -167,9 +214,15 @@ protected:
 protected:
 	void eventIo(int fd, int event, bool& del_event);
 
+private:
+	void _dispatchAccept(accept_type& param);
+
 private:
 	bool open(const char* host, const char* service, int family = PF_INET, int socktype = SOCK_STREAM, int protocol = 0) = delete;
 	bool open(const SocketAddress& sa, int socktype = SOCK_STREAM, int protocol = 0) = delete;
+
+private:
+	int		m_type{LT_NONE};	//!< SO_REUSEPORT 모드의 리스너 타입. LT_NONE이면 페어 소켓으로 받는다.
 };
 
 };//namespace pw
@@ -32,15 +32,106 @@
 #include "./pw_string.h"
 #include "./pw_encode.h"
 #include "./pw_instance_if.h"
+#include "./pw_compress.h"
 
 namespace pw {
 
-MsgChannel::MsgChannel(const chif_create_type& param) : ChannelInterface(param), m_dest_bodylen(0), m_recv_bodylen(0), m_last_sent(Timer::s_getNow())
+MsgChannel::MsgChannel(const chif_create_type& param) : ChannelInterface(param), m_dest_bodylen(0), m_recv_bodylen(0), m_last_sent(Timer::s_getNow()), m_binary(false), m_binary_send(false), m_codec(nullptr), m_chunk_limit(0)
 {
 }
 
 MsgChannel::~MsgChannel()
 {
+	if ( m_codec ) delete m_codec;
+}
+
+MsgChannel::codec_type::~codec_type()
+{
+	if ( deflate ) Compress::s_release(deflate);
+	if ( inflate ) Compress::s_release(inflate);
+	if ( encrypt ) Crypto::s_release(encrypt);
+	if ( decrypt ) Crypto::s_release(decrypt);
+}
+
+void
+MsgChannel::chunk_type::clear(void)
+{
+	// 큰 패킷을 모았던 공간은 돌려준다.
+	if ( body.capacity() > size_t(MsgPacket::limit_type::MAX_BODY_SIZE) ) std::string().swap(body);
+	else body.clear();
+
+	trid = total = next = 0;
+}
+
+bool
+MsgChannel::setCompress(int level, size_t min_size)
+{
+	if ( level < 0 )
+	{
+		if ( m_codec )
+		{
+			if ( m_codec->deflate ) { Compress::s_release(m_codec->deflate); m_codec->deflate = nullptr; }
+			if ( m_codec->inflate ) { Compress::s_release(m_codec->inflate); m_codec->inflate = nullptr; }
+			if ( m_codec->empty() ) { delete m_codec; m_codec = nullptr; }
+		}
+
+		return true;
+	}
+
+	Compress* deflate(Compress::s_createCompress(level, PWStr::DEFAULT_BUFFER_SIZE));
+	Compress* inflate(Compress::s_createUncompress(PWStr::DEFAULT_BUFFER_SIZE));
+	if ( (nullptr == deflate) or (nullptr == inflate) )
+	{
+		PWLOGLIB("failed to create compress: ch:%p level:%d", this, level);
+		if ( deflate ) Compress::s_release(deflate);
+		if ( inflate ) Compress::s_release(inflate);
+		return false;
+	}
+
+	if ( nullptr == m_codec ) m_codec = new codec_type;
+	if ( m_codec->deflate ) Compress::s_release(m_codec->deflate);
+	if ( m_codec->inflate ) Compress::s_release(m_codec->inflate);
+
+	m_codec->deflate = deflate;
+	m_codec->inflate = inflate;
+	m_codec->compress_min = min_size;
+
+	return true;
+}
+
+bool
+MsgChannel::setCrypto(crypto::CipherType type, const char* key, const char* iv)
+{
+	if ( crypto::CipherType::EMPTY == type )
+	{
+		if ( m_codec )
+		{
+			if ( m_codec->encrypt ) { Crypto::s_release(m_codec->encrypt); m_codec->encrypt = nullptr; }
+			if ( m_codec->decrypt ) { Crypto::s_release(m_codec->decrypt); m_codec->decrypt = nullptr; }
+			if ( m_codec->empty() ) { delete m_codec; m_codec = nullptr; }
+		}
+
+		return true;
+	}
+
+	Crypto* encrypt(Crypto::s_create(type, key, iv, Crypto::Direction::ENCRYPT));
+	Crypto* decrypt(Crypto::s_create(type, key, iv, Crypto::Direction::DECRYPT));
+	if ( (nullptr == encrypt) or (nullptr == decrypt) )
+	{
+		PWLOGLIB("failed to create crypto: ch:%p type:%d", this, int(type));
+		if ( encrypt ) Crypto::s_release(encrypt);
+		if ( decrypt ) Crypto::s_release(decrypt);
+		return false;
+	}
+
+	if ( nullptr == m_codec ) m_codec = new codec_type;
+	if ( m_codec->encrypt ) Crypto::s_release(m_codec->encrypt);
+	if ( m_codec->decrypt ) Crypto::s_release(m_codec->decrypt);
+
+	m_codec->encrypt = encrypt;
+	m_codec->decrypt = decrypt;
+
+	return true;
 }
 
 void
@@ -66,22 +157,284 @@ MsgChannel::eventTimer(int id, void* param)
 }
 
 bool
-MsgChannel::getPacketSync(MsgPacket& out)
+MsgChannel::write(const PacketInterface& pk)
 {
-	std::string header;
-	if ( not getLineSync(header, size_t(MsgPacket::limit_type::MAX_HEADER_SIZE)) )
+	if ( not (m_binary_send or m_codec) ) return ChannelInterface::write(pk);
+
+	const MsgPacket* msg(dynamic_cast<const MsgPacket*>(&pk));
+	if ( nullptr == msg ) return ChannelInterface::write(pk);
+
+	if ( m_codec and (msg->m_body.size > 0) ) return _writeEncoded(*msg);
+	if ( not m_binary_send ) return ChannelInterface::write(pk);
+
+	if ( isInstDeleteOrExpired() ) return false;
+	if ( (m_fd == -1) or (m_poller == nullptr) or (m_wbuf == nullptr) ) return false;
+	const bool was_empty(m_wbuf->isEmpty());
+	if ( msg->writeBinary(*m_wbuf) <= 0 ) return false;
+	return _armWrite(was_empty);
+}
+
+bool
+MsgChannel::_writeEncoded(const MsgPacket& pk)
+{
+	codec_type& codec(*m_codec);
+	const char* body(pk.m_body.buf);
+	size_t blen(pk.m_body.size);
+
+	// 헤더만 쓸 패킷. 바디 길이는 바꿔 쓸 길이로 설정한다.
+	MsgPacket head;
+	head.m_code = pk.m_code;
+	head.m_trid = pk.m_trid;
+	head.m_flags = pk.m_flags;
+	head.m_chunked = pk.m_chunked;
+	head.m_appendix = pk.m_appendix;
+
+	// 이미 압축했거나 암호화한 바디는 그대로 보낸다.
+	const bool encoded(pk.isFlagCompressed() or pk.isFlagEncrypted());
+
+	if ( codec.deflate and (not encoded) and (blen >= codec.compress_min) and (blen <= size_t(MsgPacket::limit_type::MAX_BODY_SIZE)) )
+	{
+		codec.tx.clear();
+		if ( codec.deflate->reinitialize()
+			and codec.deflate->update(codec.tx, body, blen)
+			and codec.deflate->finalize(codec.tx)
+			and (codec.tx.size() < blen) )
+		{
+			body = codec.tx.c_str();
+			blen = codec.tx.size();
+			head.setFlag(MsgPacket::flag_type::COMPRESSED, true);
+		}
+	}
+
+	const bool encrypt(codec.encrypt and (not encoded));
+	const size_t olen(encrypt ? codec.encrypt->getEncryptedSize(blen) : blen);
+	if ( encrypt )
+	{
+		// 패딩으로 늘어난 바디를 상대가 받을 수 없으면 보내지 않는다.
+		if ( olen > size_t(MsgPacket::limit_type::MAX_BODY_SIZE) )
+		{
+			PWLOGLIB("too long body to encrypt: ch:%p input:%zu output:%zu", this, blen, olen);
+			return false;
+		}
+
+		head.setFlag(MsgPacket::flag_type::ENCRYPTED, true);
+	}
+
+	head.m_body.type = blob_type::CT_POINTER;
+	head.m_body.size = olen;
+
+	if ( isInstDeleteOrExpired() ) return false;
+	if ( (m_fd == -1) or (m_poller == nullptr) or (m_wbuf == nullptr) ) return false;
+
+	const size_t hlen(head.getHeaderSize(m_binary_send));
+	if ( 0 == hlen )
+	{
+		PWLOGLIB("too long appendix: ch:%p input:%zu", this, pk.m_appendix.size());
+		return false;
+	}
+
+	const bool was_empty(m_wbuf->isEmpty());
+	IoBuffer::blob_type b;
+	if ( not m_wbuf->grabWrite(b, hlen + olen) ) return false;
+
+	char* p(head.writeHeader(b.buf, m_binary_send));
+	if ( encrypt )
+	{
+		// 암호문을 쓰기 버퍼에 바로 쓴다.
+		size_t elen(olen);
+		if ( (not codec.encrypt->execute(p, &elen, body, blen)) or (elen not_eq olen) )
+		{
+			PWLOGLIB("failed to encrypt: ch:%p input:%zu output:%zu expected:%zu", this, blen, elen, olen);
+			return false;
+		}
+	}
+	else if ( olen > 0 )
+	{
+		::memcpy(p, body, olen);
+	}
+
+	m_wbuf->moveWrite(hlen + olen);
+	return _armWrite(was_empty);
+}
+
+bool
+MsgChannel::_decodeBody(MsgPacket& pk)
+{
+	codec_type& codec(*m_codec);
+	const char* body(pk.m_body.buf);
+	size_t blen(pk.m_body.size);
+
+	if ( pk.isFlagEncrypted() and codec.decrypt )
+	{
+		codec.rx_crypt.resize(blen + codec.decrypt->getBlockSize());
+		size_t olen(codec.rx_crypt.size());
+		if ( not codec.decrypt->execute(const_cast<char*>(codec.rx_crypt.data()), &olen, body, blen) )
+		{
+			PWLOGLIB("failed to decrypt: ch:%p input:%zu", this, blen);
+			return false;
+		}
+
+		codec.rx_crypt.resize(olen);
+		body = codec.rx_crypt.c_str();
+		blen = olen;
+		pk.setFlag(MsgPacket::flag_type::ENCRYPTED, false);
+	}
+
+	if ( pk.isFlagCompressed() and codec.inflate and (not pk.isFlagEncrypted()) )
+	{
+		// 풀어낸 크기가 최대 바디 크기를 넘지 않도록 나눠서 푼다.
+		const size_t limit(size_t(MsgPacket::limit_type::MAX_BODY_SIZE));
+		codec.rx.clear();
+		bool res(codec.inflate->reinitialize());
+		for ( size_t off(0); res and (off < blen); off += PWStr::DEFAULT_BUFFER_SIZE )
+		{
+			res = codec.inflate->update(codec.rx, body + off, std::min(size_t(PWStr::DEFAULT_BUFFER_SIZE), blen - off));
+			if ( codec.rx.size() > limit ) res = false;
+		}
+
+		if ( res ) res = ( codec.inflate->finalize(codec.rx) and (codec.rx.size() <= limit) );
+		if ( not res )
+		{
+			PWLOGLIB("failed to uncompress: ch:%p input:%zu output:%zu", this, blen, codec.rx.size());
+			return false;
+		}
+
+		body = codec.rx.c_str();
+		blen = codec.rx.size();
+		pk.setFlag(MsgPacket::flag_type::COMPRESSED, false);
+	}
+
+	if ( body not_eq pk.m_body.buf )
+	{
+		blob_type tmp(body, blen, blob_type::CT_POINTER);
+		pk.m_body.swap(tmp);
+	}
+
+	return true;
+}
+
+bool
+MsgChannel::_gatherChunk(MsgPacket& pk)
+{
+	const uint16_t total(pk.m_chunked.total());
+	const uint16_t index(pk.m_chunked.index());
+
+	if ( 1 == index )
+	{
+		if ( m_chunk.next ) PWLOGLIB("drop incomplete chunks: ch:%p trid:%d next:%d total:%d", this, int(m_chunk.trid), int(m_chunk.next), int(m_chunk.total));
+		m_chunk.clear();
+		m_chunk.trid = pk.m_trid;
+		m_chunk.total = total;
+		m_chunk.next = 1;
+	}
+
+	if ( (index not_eq m_chunk.next) or (total not_eq m_chunk.total) or (pk.m_trid not_eq m_chunk.trid) )
+	{
+		PWLOGLIB("invalid chunk: ch:%p trid:%d index:%d total:%d expected:%d/%d", this, int(pk.m_trid), int(index), int(total), int(m_chunk.next), int(m_chunk.total));
+		m_chunk.clear();
+		return false;
+	}
+
+	if ( m_chunk.body.size() + pk.m_body.size > m_chunk_limit )
 	{
-		PWLOGLIB("failed to get line sync");
+		PWLOGLIB("too long chunked packet: ch:%p trid:%d limit:%zu", this, int(pk.m_trid), m_chunk_limit);
+		m_chunk.clear();
 		return false;
 	}
 
+	if ( pk.m_body.size ) m_chunk.body.append(pk.m_body.buf, pk.m_body.size);
+
+	if ( index < total )
+	{
+		++m_chunk.next;
+		return true;
+	}
+
+	// 다 모았으면 마지막 헤더로 하나의 패킷을 만들어 전달한다.
+	pk.setFlag(MsgPacket::flag_type::CHUNKED, false);
+	pk.m_chunked.clear();
+
+	blob_type tmp(m_chunk.body.c_str(), m_chunk.body.size(), blob_type::CT_POINTER);
+	pk.m_body.swap(tmp);
+
+	hookReadPacket(pk, pk.m_body.buf, pk.m_body.size);
+	pk.m_body.clear();
+	m_chunk.clear();
+
+	return true;
+}
+
+bool
+MsgChannel::_deliverPacket(MsgPacket& pk)
+{
+	if ( m_codec and (pk.isFlagEncrypted() or pk.isFlagCompressed()) and (pk.m_body.size > 0) )
+	{
+		if ( not _decodeBody(pk) ) return false;
+	}
+
+	if ( m_chunk_limit and pk.isFlagChunked() ) return _gatherChunk(pk);
+
+	hookReadPacket(pk, pk.m_body.buf, pk.m_body.size);
+	return true;
+}
+
+bool
+MsgChannel::getPacketSync(MsgPacket& out)
+{
+	std::string header;
 	MsgPacket tmp;
-	if ( not tmp.setHeader(header.c_str(), header.size()) )
+
+	char c(0x00);
+	if ( not getDataSync(&c, 1) )
 	{
-		PWLOGLIB("failed to set header");
+		PWLOGLIB("failed to get data sync");
 		return false;
 	}
 
+	if ( m_binary and MsgPacket::s_isBinaryHeader(&c, 1) )
+	{
+		std::string tail;
+		if ( not getDataSync(tail, size_t(MsgPacket::BINARY_HEADER_SIZE) - 1) )
+		{
+			PWLOGLIB("failed to get binary header sync");
+			return false;
+		}
+
+		header.assign(1, c).append(tail);
+		const size_t hlen(MsgPacket::s_getBinaryHeaderSize(header.c_str(), header.size()));
+		if ( (hlen > header.size()) and (not getDataSync(tail, hlen - header.size())) )
+		{
+			PWLOGLIB("failed to get binary appendix sync");
+			return false;
+		}
+		if ( hlen > header.size() ) header.append(tail);
+
+		if ( not tmp.setBinaryHeader(header.c_str(), header.size()) )
+		{
+			PWLOGLIB("failed to set binary header");
+			return false;
+		}
+
+		m_binary_send = true;
+	}
+	else
+	{
+		if ( not getLineSync(header, size_t(MsgPacket::limit_type::MAX_HEADER_SIZE)) )
+		{
+			PWLOGLIB("failed to get line sync");
+			return false;
+		}
+
+		header.insert(header.begin(), c);
+		if ( not tmp.setHeader(header.c_str(), header.size()) )
+		{
+			PWLOGLIB("failed to set header");
+			return false;
+		}
+
+		if ( m_binary and tmp.isFlagBinary() ) m_binary_send = true;
+	}
+
 	if ( tmp.getBodySize() )
 	{
 		blob_type& body(tmp.m_body);
@@ -92,6 +445,15 @@ MsgChannel::getPacketSync(MsgPacket& out)
 		}
 	}
 
+	if ( m_codec and (tmp.isFlagEncrypted() or tmp.isFlagCompressed()) and tmp.getBodySize() )
+	{
+		if ( not _decodeBody(tmp) ) return false;
+
+		// 풀어낸 바디는 채널 버퍼를 가리키므로 복사한다.
+		blob_type body(tmp.m_body, blob_type::CT_MALLOC);
+		tmp.m_body.swap(body);
+	}
+
 	out.swap(tmp);
 	return true;
 }
@@ -124,35 +486,77 @@ MsgChannel::eventReadData(size_t len)
 
 			IoBuffer::blob_type b;
 			m_rbuf->grabRead(b);
-			const char* eol(PWStr::findLine(b.buf, b.size));
-			if ( nullptr == eol )
+			if ( MsgPacket::s_isBinaryHeader(b.buf, b.size) )
 			{
-				if ( b.size > size_t(MsgPacket::limit_type::MAX_HEADER_SIZE) )
+				if ( not m_binary )
 				{
-					PWLOGLIB("too long header: input:%jd", intmax_t(b.size));
+					PWLOGLIB("binary header is not allowed: ch:%p chtype:%s", this, typeid(*this).name());
 					m_recv_state = RecvState::ERROR;
 					goto PROC_ERROR;
 				}
 
-				return;
-			}
+				const size_t hlen(MsgPacket::s_getBinaryHeaderSize(b.buf, b.size));
+				if ( hlen > size_t(MsgPacket::limit_type::MAX_HEADER_SIZE) )
+				{
+					PWLOGLIB("too long header: input:%zu", hlen);
+					m_recv_state = RecvState::ERROR;
+					goto PROC_ERROR;
+				}
 
-			const size_t cplen(eol - b.buf);
-			if ( not m_recv.setHeader(b.buf, cplen) )
+				// 아직 헤더를 다 받지 못함.
+				if ( (0 == hlen) or (hlen > b.size) ) return;
+
+				if ( not m_recv.setBinaryHeader(b.buf, hlen, false) )
+				{
+					std::string out;
+					PWEnc::encodeHex(out, b.buf, hlen);
+					PWLOGLIB("invalid packet: ch:%p chtype:%s header:%s", this, typeid(*this).name(), out.c_str());
+
+					m_rbuf->moveRead(hlen);
+
+					m_recv_state = RecvState::ERROR;
+					goto PROC_ERROR;
+				}
+
+				m_rbuf->moveRead(hlen);
+
+				// 바이너리 헤더를 보냈으니 상대도 받을 수 있다.
+				m_binary_send = true;
+			}
+			else
 			{
-				// invalid packet
-				std::string out;
-				PWEnc::encodeHex(out, b.buf, cplen);
-				PWLOGLIB("invalid packet: ch:%p chtype:%s header:%s", this, typeid(*this).name(), out.c_str());
+				const char* eol(PWStr::findLine(b.buf, b.size));
+				if ( nullptr == eol )
+				{
+					if ( b.size > size_t(MsgPacket::limit_type::MAX_HEADER_SIZE) )
+					{
+						PWLOGLIB("too long header: input:%jd", intmax_t(b.size));
+						m_recv_state = RecvState::ERROR;
+						goto PROC_ERROR;
+					}
+
+					return;
+				}
+
+				const size_t cplen(eol - b.buf);
+				if ( not m_recv.setHeader(b.buf, cplen, false) )
+				{
+					// invalid packet
+					std::string out;
+					PWEnc::encodeHex(out, b.buf, cplen);
+					PWLOGLIB("invalid packet: ch:%p chtype:%s header:%s", this, typeid(*this).name(), out.c_str());
+
+					m_rbuf->moveRead(cplen+2);
+
+					m_recv_state = RecvState::ERROR;
+					goto PROC_ERROR;
+				}
 
 				m_rbuf->moveRead(cplen+2);
 
-				m_recv_state = RecvState::ERROR;
-				goto PROC_ERROR;
+				if ( m_binary and m_recv.isFlagBinary() ) m_binary_send = true;
 			}
 
-			m_rbuf->moveRead(cplen+2);
-
 			if ( (m_dest_bodylen = m_recv.getBodySize()) > 0 )
 			{
 				m_recv_state = RecvState::BODY;
@@ -162,7 +566,12 @@ MsgChannel::eventReadData(size_t len)
 				//m_recv_state = RecvState::DONE;
 				//PWTRACE("RecvState::DONE: %p", this);
 				//eventReadPacket(m_recv, m_recv.m_body.buf, m_recv.m_body.size);
-				hookReadPacket(m_recv, m_recv.m_body.buf, m_recv.m_body.size);
+				if ( not _deliverPacket(m_recv) )
+				{
+					m_recv_state = RecvState::ERROR;
+					goto PROC_ERROR;
+				}
+
 				m_recv_state = RecvState::START;
 				break;
 			}
@@ -174,6 +583,32 @@ MsgChannel::eventReadData(size_t len)
 			blob_type& body(m_recv.m_body);
 			if ( body.buf == nullptr )
 			{
+				const size_t readable(m_rbuf->getReadableSize());
+				if ( readable >= m_dest_bodylen )
+				{
+					// 바디를 모두 받았으면 복사하지 않고 읽기 버퍼를 가리킨다.
+					// 콜백이 끝나면 읽은 것으로 처리하므로 콜백 안에서만 유효하다.
+					IoBuffer::blob_type b;
+					m_rbuf->grabRead(b);
+					body.buf = b.buf;
+					const bool res(_deliverPacket(m_recv));
+					body.clear();
+					m_rbuf->moveRead(m_dest_bodylen);
+					if ( not res )
+					{
+						m_recv_state = RecvState::ERROR;
+						goto PROC_ERROR;
+					}
+
+					m_recv_state = RecvState::START;
+					break;
+				}
+
+				// 남은 바디가 들어갈 자리를 한 번에 마련하고 모두 받을 때까지 기다린다.
+				IoBuffer::blob_type w;
+				if ( m_rbuf->grabWrite(w, m_dest_bodylen - readable) ) return;
+
+				// 자리를 마련하지 못하면 받은 만큼씩 복사한다.
 				if ( not body.allocate(m_dest_bodylen) )
 				{
 					PWLOGLIB("not enough memory");
@@ -205,7 +640,12 @@ MsgChannel::eventReadData(size_t len)
 		case RecvState::DONE:
 		{
 			//PWTRACE("RecvState::DONE: %p", this);
-			hookReadPacket(m_recv, m_recv.m_body.buf, m_recv.m_body.size);
+			if ( not _deliverPacket(m_recv) )
+			{
+				m_recv_state = RecvState::ERROR;
+				goto PROC_ERROR;
+			}
+
 			m_recv_state = RecvState::START;
 			break;
 		}// case RecvState::DONE
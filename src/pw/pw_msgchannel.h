@@ -32,21 +32,25 @@
 #include "./pw_msgpacket.h"
 #include "./pw_channel_if.h"
 #include "./pw_timer.h"
+#include "./pw_crypto.h"
 
 #ifndef __PW_MSGCHANNEL_H__
 #define __PW_MSGCHANNEL_H__
 
 namespace pw {
 
+class Compress;
+
 //! \brief 메시지 채널
-//! \warning 메시지 패킷의 암호화/청크/압축을 채널라이브러리에서 지원하지 않는다.
-//!	필요한 기능은 각 말단에서 구현해야 한다.
+//! \details 설정하면 바디 압축과 암호화, CHUNKED 패킷 모으기를 채널에서 처리한다.
+//!	압축과 암호화는 양쪽 모두 같은 설정이어야 하며, 설정하지 않은 채널은 플래그만 전달한다.
 class MsgChannel : public ChannelInterface, public ChannelPingInterface, public pw::Timer::Event
 {
 public:
 	enum
 	{
 		TIMER_CHECK_10SEC = 25000,	//!< 10초에 한 번씩 검사
+		DEFAULT_COMPRESS_MIN = 512,	//!< 이보다 작은 바디는 압축하지 않는다.
 	};
 
 public:
@@ -56,6 +60,51 @@ public:
 public:
 	bool getPacketSync(MsgPacket& pk);
 
+	using ChannelInterface::write;
+
+	//! \brief 패킷을 보낸다. 상대가 바이너리 헤더를 받을 수 있으면 바이너리 헤더로 보낸다.
+	bool write(const PacketInterface& pk) override;
+
+	//! \brief 바이너리 헤더 사용 여부를 설정한다.
+	//! \details 켜면 바이너리 헤더를 받을 수 있고, 상대도 받을 수 있다는 것을 알면 바이너리 헤더로 보낸다.
+	//!	상대가 BINARY 플래그를 켠 패킷이나 바이너리 헤더 패킷을 보내면 받을 수 있는 것으로 본다.
+	//!	MultiChannelInterface는 헬로 패킷에 BINARY 플래그를 켜서 알린다.
+	inline void setBinaryFraming(bool enable) { m_binary = enable; if ( not enable ) m_binary_send = false; }
+
+	//! \brief 바이너리 헤더를 받을 수 있는지 여부
+	inline bool isBinaryFraming(void) const { return m_binary; }
+
+	//! \brief 바이너리 헤더로 보내고 있는지 여부
+	inline bool isBinarySending(void) const { return m_binary_send; }
+
+	//! \brief 바디 압축을 설정한다.
+	//! \details min_size 이상인 바디를 압축해서 줄어들 때만 COMPRESSED 플래그를 켜서 보내고,
+	//!	COMPRESSED 플래그가 있는 패킷은 풀어서 전달한다. 압축 객체는 채널이 끝날 때까지 다시 사용한다.
+	//! \param[in] level 압축 레벨. 음수면 압축을 끈다.
+	//! \param[in] min_size 압축할 최소 바디 크기
+	bool setCompress(int level, size_t min_size = DEFAULT_COMPRESS_MIN);
+
+	//! \brief 바디 압축 여부
+	inline bool isCompress(void) const { return m_codec and m_codec->deflate; }
+
+	//! \brief 바디 암호화를 설정한다.
+	//! \details 바디를 암호화하여 ENCRYPTED 플래그를 켜서 보내고,
+	//!	ENCRYPTED 플래그가 있는 패킷은 복호화해서 전달한다. 압축과 함께 쓰면 압축한 뒤 암호화한다.
+	//! \param[in] type 암호화 알고리즘. crypto::CipherType::EMPTY이면 암호화를 끈다.
+	//! \param[in] key 키. 알고리즘의 키 길이만큼 있어야 한다.
+	//! \param[in] iv IV. 알고리즘의 IV 길이만큼 있어야 한다.
+	bool setCrypto(crypto::CipherType type, const char* key, const char* iv);
+
+	//! \brief 바디 암호화 여부
+	inline bool isCrypto(void) const { return m_codec and m_codec->encrypt; }
+
+	//! \brief CHUNKED 패킷을 모아서 하나의 패킷으로 전달한다.
+	//! \param[in] limit 모은 바디의 최대 크기. 0이면 모으지 않고 하나씩 전달한다.
+	inline void setChunkLimit(size_t limit) { m_chunk_limit = limit; if ( 0 == limit ) m_chunk.clear(); }
+
+	//! \brief 모을 수 있는 CHUNKED 패킷 바디의 최대 크기
+	inline size_t getChunkLimit(void) const { return m_chunk_limit; }
+
 protected:
 	//! \brief 서비스 채널을 위한 eventReadPacket 호출 후크
 	//!	어플리케이션에서 상속할 일 없음.
@@ -77,11 +126,59 @@ protected:
 	size_t			m_dest_bodylen;	//!< 목표 패킷 길이
 	size_t			m_recv_bodylen;	//!< 읽은 패킷 바디
 	int64_t		m_last_sent;	//!< 마지막 패킷 보낸 시간
+	bool			m_binary;		//!< 바이너리 헤더 사용
+	bool			m_binary_send;	//!< 상대와 합의하여 바이너리 헤더로 보낸다.
+
+private:
+	//! \brief 바디 압축과 암호화에 쓰는 객체.
+	struct codec_type final
+	{
+		Compress*	deflate{nullptr};
+		Compress*	inflate{nullptr};
+		Crypto*		encrypt{nullptr};
+		Crypto*		decrypt{nullptr};
+		size_t		compress_min{DEFAULT_COMPRESS_MIN};
+		std::string	tx;		//!< 압축한 바디
+		std::string	rx;		//!< 풀어낸 바디
+		std::string	rx_crypt;	//!< 복호화한 바디
+
+		~codec_type();
+
+		inline bool empty(void) const { return not (deflate or encrypt); }
+	};
+
+	//! \brief 모으고 있는 CHUNKED 패킷
+	struct chunk_type final
+	{
+		std::string	body;
+		uint16_t	trid{0};
+		uint16_t	total{0};
+		uint16_t	next{0};	//!< 기다리는 인덱스. 0이면 모으고 있지 않다.
+
+		void clear(void);
+	};
 
 private:
 	//! \brief 패킷 해석. 상속하지 말 것.
 	void eventReadData(size_t len) override;
 
+	//! \brief 바디를 풀고 CHUNKED 패킷을 모아서 전달한다.
+	bool _deliverPacket(MsgPacket& pk);
+
+	//! \brief 암호화와 압축을 풀어서 바디를 바꾼다. 바뀐 바디는 다음 패킷을 풀 때까지 유효하다.
+	bool _decodeBody(MsgPacket& pk);
+
+	//! \brief CHUNKED 패킷을 모으고 다 모으면 전달한다.
+	bool _gatherChunk(MsgPacket& pk);
+
+	//! \brief 바디를 압축하거나 암호화해서 쓰기 버퍼에 바로 쓴다.
+	bool _writeEncoded(const MsgPacket& pk);
+
+private:
+	codec_type*	m_codec;		//!< 압축, 암호화를 설정할 때만 만든다.
+	size_t		m_chunk_limit;	//!< CHUNKED 패킷을 모을 최대 크기
+	chunk_type	m_chunk;
+
 };
 
 };//namespace pw
@@ -50,26 +50,228 @@ _str2ulong(const char* buf)
 	return ret;
 }
 
+//! \brief 두 자리씩 숫자를 쓸 때 사용하는 표
+static const char s_digits[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+//! \brief 10진수 자리수를 구한다.
+inline
+static
+size_t
+_getDigitCount(uint64_t v)
+{
+	size_t n(1);
+	while ( v >= 100 ) { v /= 100; n += 2; }
+	if ( v >= 10 ) ++n;
+	return n;
+}
+
+//! \brief len 자리로 10진수를 쓰고 다음 위치를 반환한다.
 inline
 static
 char*
-_uint82str(char* buf, uint8_t flags)
+_putDecimal(char* p, uint64_t v, size_t len)
 {
-	if ( 0 == flags )
+	char* const e(p + len);
+	char* q(e);
+	while ( v >= 100 )
 	{
-		buf[0] = '0';
-		buf[1] = 0x00;
+		const size_t i((v % 100) * 2);
+		v /= 100;
+		*--q = s_digits[i+1];
+		*--q = s_digits[i];
 	}
 
-	int i(0);
-	while ( i < 3 )
+	if ( v >= 10 )
 	{
-		buf[i] = ((flags >> i) bitand 1) ? '1' : '0';
-		++i;
+		const size_t i(v * 2);
+		*--q = s_digits[i+1];
+		*--q = s_digits[i];
 	}
-	buf[3] = 0x00;
+	else
+	{
+		*--q = char('0' + v);
+	}
+
+	return e;
+}
 
-	return buf;
+//! \brief 플래그 문자열 길이.
+//! 예전 형식과 같게 세 자리를 쓰고, 그 위의 비트가 있을 때만 늘린다.
+inline
+static
+size_t
+_getFlagsLength(uint8_t flags)
+{
+	size_t len(3);
+	while ( (len < 8) and (flags >> len) ) ++len;
+	return len;
+}
+
+//! \brief 플래그 문자열을 쓰고 다음 위치를 반환한다.
+inline
+static
+char*
+_putFlags(char* p, uint8_t flags, size_t len)
+{
+	for ( size_t i(0); i < len; i++ ) p[i] = ((flags >> i) bitand 1) ? '1' : '0';
+	return p + len;
+}
+
+inline
+static
+void
+_put16(char* p, uint16_t v)
+{
+	p[0] = char(v bitand 0xff);
+	p[1] = char((v >> 8) bitand 0xff);
+}
+
+inline
+static
+void
+_put32(char* p, uint32_t v)
+{
+	p[0] = char(v bitand 0xff);
+	p[1] = char((v >> 8) bitand 0xff);
+	p[2] = char((v >> 16) bitand 0xff);
+	p[3] = char((v >> 24) bitand 0xff);
+}
+
+inline
+static
+uint16_t
+_get16(const char* p)
+{
+	return uint16_t(uint8_t(p[0])) bitor uint16_t(uint16_t(uint8_t(p[1])) << 8);
+}
+
+inline
+static
+uint32_t
+_get32(const char* p)
+{
+	return uint32_t(uint8_t(p[0])) bitor (uint32_t(uint8_t(p[1])) << 8) bitor (uint32_t(uint8_t(p[2])) << 16) bitor (uint32_t(uint8_t(p[3])) << 24);
+}
+
+//! \brief 헤더에서 읽은 바디 크기를 설정한다.
+static
+bool
+_setBodySize(blob_type& body, intmax_t blen, bool alloc_body)
+{
+	if ( blen > intmax_t(MsgPacket::limit_type::MAX_BODY_SIZE) )
+	{
+		PWLOGLIB("too large body size: input:%jd limit:%jd", blen, intmax_t(MsgPacket::limit_type::MAX_BODY_SIZE));
+		return false;
+	}
+
+	if ( blen <= 0 ) return true;
+
+	if ( not alloc_body )
+	{
+		// 바디를 채울 쪽에서 버퍼를 정한다.
+		body.type = blob_type::CT_POINTER;
+		body.size = size_t(blen);
+		return true;
+	}
+
+	if ( not body.allocate(blen) )
+	{
+		PWLOGLIB("not enough memory: body size:%jd", blen);
+		return false;
+	}
+
+	return true;
+}
+
+//! \brief 바이너리 헤더와 APPENDIX를 쓰고 다음 위치를 반환한다.
+static
+char*
+_putBinaryHeader(char* p, const MsgPacket& pk)
+{
+	p[0] = char(MsgPacket::BINARY_MAGIC);
+	p[1] = char(pk.m_flags);
+	_put16(p+2, pk.m_trid);
+	::memset(p+4, 0x00, PW_CODE_SIZE);
+	::memcpy(p+4, pk.m_code.c_str(), std::min(pk.m_code.size(), size_t(PW_CODE_SIZE)));
+	_put32(p+8, uint32_t(pk.m_body.size));
+	_put16(p+12, pk.isFlagChunked() ? pk.m_chunked.total() : 0);
+	_put16(p+14, pk.isFlagChunked() ? pk.m_chunked.index() : 0);
+	_put16(p+16, uint16_t(pk.m_appendix.size()));
+	_put16(p+18, 0);
+	p += MsgPacket::BINARY_HEADER_SIZE;
+
+	if ( not pk.m_appendix.empty() )
+	{
+		::memcpy(p, pk.m_appendix.c_str(), pk.m_appendix.size());
+		p += pk.m_appendix.size();
+	}
+
+	return p;
+}
+
+//! \brief 텍스트 헤더 길이. \\r\\n을 포함한다.
+static
+size_t
+_getTextHeaderSize(const MsgPacket& pk)
+{
+	size_t sum(pk.m_code.size() + 1
+		+ _getDigitCount(pk.m_trid) + 1
+		+ _getFlagsLength(pk.m_flags) + 1
+		+ _getDigitCount(pk.m_body.size) + 2);
+
+	if ( pk.isFlagChunked() )
+	{
+		sum += 1 + _getDigitCount(pk.m_chunked.total()) + 1 + _getDigitCount(pk.m_chunked.index());
+	}
+
+	if ( not pk.m_appendix.empty() ) sum += pk.m_appendix.size() + 1;
+
+	return sum;
+}
+
+//! \brief 텍스트 헤더를 쓰고 다음 위치를 반환한다.
+static
+char*
+_putTextHeader(char* p, const MsgPacket& pk)
+{
+	::memcpy(p, pk.m_code.c_str(), pk.m_code.size());
+	p += pk.m_code.size();
+	*p++ = ' ';
+	p = _putDecimal(p, pk.m_trid, _getDigitCount(pk.m_trid));
+	*p++ = ' ';
+	p = _putFlags(p, pk.m_flags, _getFlagsLength(pk.m_flags));
+	*p++ = ' ';
+	p = _putDecimal(p, pk.m_body.size, _getDigitCount(pk.m_body.size));
+
+	if ( pk.isFlagChunked() )
+	{
+		*p++ = ' ';
+		p = _putDecimal(p, pk.m_chunked.total(), _getDigitCount(pk.m_chunked.total()));
+		*p++ = ' ';
+		p = _putDecimal(p, pk.m_chunked.index(), _getDigitCount(pk.m_chunked.index()));
+	}
+
+	if ( not pk.m_appendix.empty() )
+	{
+		*p++ = ' ';
+		::memcpy(p, pk.m_appendix.c_str(), pk.m_appendix.size());
+		p += pk.m_appendix.size();
+	}
+
+	*p++ = '\r';
+	*p++ = '\n';
+
+	return p;
 }
 
 MsgPacket::MsgPacket() : m_trid(0), m_flags(0)
@@ -108,7 +310,7 @@ MsgPacket::swap(MsgPacket& pk)
 }
 
 bool
-MsgPacket::setHeader(const char* buf, size_t blen)
+MsgPacket::setHeader(const char* buf, size_t blen, bool alloc_body)
 {
 	//PWTRACE("%s %s", __func__, buf);
 	MsgPacket tmp;
@@ -125,21 +327,7 @@ MsgPacket::setHeader(const char* buf, size_t blen)
 
 		// Body size
 		if ( not tok.getNext(tmpstr, sizeof(tmpstr), ' ') ) break;
-		intmax_t blen(strtoimax(tmpstr, nullptr, 10));
-		if ( blen > intmax_t(limit_type::MAX_BODY_SIZE) )
-		{
-			PWLOGLIB("too large body size: input:%jd limit:%jd", blen, intmax_t(limit_type::MAX_BODY_SIZE));
-			break;
-		}
-
-		if ( blen > 0 )
-		{
-			if ( not tmp.m_body.allocate(blen) )
-			{
-				PWLOGLIB("not enough memory: body size:%jd", blen);
-				break;
-			}
-		}
+		if ( not _setBodySize(tmp.m_body, strtoimax(tmpstr, nullptr, 10), alloc_body) ) break;
 
 		// Chunked info
 		if ( tmp.isFlagChunked() )
@@ -168,82 +356,135 @@ MsgPacket::setHeader(const char* buf, size_t blen)
 }
 
 size_t
-MsgPacket::getPacketSize(void) const
+MsgPacket::s_getBinaryHeaderSize(const char* buf, size_t blen)
+{
+	if ( blen < size_t(BINARY_HEADER_SIZE) ) return 0;
+	return size_t(BINARY_HEADER_SIZE) + _get16(buf+16);
+}
+
+bool
+MsgPacket::setBinaryHeader(const char* buf, size_t blen, bool alloc_body)
 {
-	char strflags[3+1];
+	if ( not s_isBinaryHeader(buf, blen) )
+	{
+		PWLOGLIB("not binary header");
+		return false;
+	}
 
-	size_t sum = snprintf(nullptr, 0, "%s %d %s %zu",
-			m_code.c_str(),
-			static_cast<int>(m_trid),
-			_uint82str(strflags, m_flags),
-			m_body.size) + 2;
+	const size_t hlen(s_getBinaryHeaderSize(buf, blen));
+	if ( (0 == hlen) or (hlen > blen) )
+	{
+		PWLOGLIB("not enough binary header: input:%zu need:%zu", blen, hlen);
+		return false;
+	}
 
-	if ( isFlagChunked() )
+	if ( hlen > size_t(limit_type::MAX_HEADER_SIZE) )
 	{
-		sum += snprintf(nullptr, 0, " %d %d", static_cast<int>(m_chunked.total()), static_cast<int>(m_chunked.index()));
+		PWLOGLIB("too long header: input:%zu limit:%jd", hlen, intmax_t(limit_type::MAX_HEADER_SIZE));
+		return false;
 	}
 
-	if ( not m_appendix.empty() ) sum += m_appendix.size() + 1;
+	MsgPacket tmp;
+	tmp.m_flags = uint8_t(buf[1]);
+	tmp.m_trid = _get16(buf+2);
+	tmp.m_code.assign(buf+4, ::strnlen(buf+4, PW_CODE_SIZE));
+	if ( not _setBodySize(tmp.m_body, intmax_t(_get32(buf+8)), alloc_body) ) return false;
 
-	if ( m_body.size ) sum += m_body.size;
+	if ( tmp.isFlagChunked() )
+	{
+		tmp.m_chunked.total() = _get16(buf+12);
+		tmp.m_chunked.index() = _get16(buf+14);
 
-	return sum;
+		if ( (tmp.m_chunked.total() > 0) and (tmp.m_chunked.index() == 0) )
+		{
+			// 잘못된 인덱스
+			PWLOGLIB("invalid index: total:%d index:%d", int(tmp.m_chunked.total()), int(tmp.m_chunked.index()));
+			return false;
+		}
+	}
+
+	tmp.m_appendix.assign(buf + BINARY_HEADER_SIZE, hlen - BINARY_HEADER_SIZE);
+	swap(tmp);
+
+	return true;
+}
+
+size_t
+MsgPacket::getBinaryPacketSize(void) const
+{
+	return size_t(BINARY_HEADER_SIZE) + m_appendix.size() + m_body.size;
 }
 
 ssize_t
-MsgPacket::write(IoBuffer& obuf) const
+MsgPacket::writeBinary(IoBuffer& obuf) const
 {
-	PWSHOWMETHOD();
-	const ssize_t pklen(getPacketSize());
-	char strflags[3+1];
+	if ( m_appendix.size() > size_t(limit_type::MAX_HEADER_SIZE) - BINARY_HEADER_SIZE )
+	{
+		PWLOGLIB("too long appendix: input:%zu", m_appendix.size());
+		return ssize_t(-1);
+	}
+
+	const size_t pklen(getBinaryPacketSize());
 
 	IoBuffer::blob_type b;
-	if ( not obuf.grabWrite(b, pklen+1) ) return ssize_t(-1);
+	if ( not obuf.grabWrite(b, pklen) ) return ssize_t(-1);
 
-	ssize_t sum = snprintf(b.buf, pklen+1, "%s %d %s %zu",
-			m_code.c_str(),
-			static_cast<int>(m_trid),
-			_uint82str(strflags, m_flags),
-			m_body.size);
+	char* p(_putBinaryHeader(b.buf, *this));
+	if ( m_body.size ) ::memcpy(p, m_body.buf, m_body.size);
 
-	if ( isFlagChunked() )
-	{
-		sum += snprintf(b.buf+sum, pklen+1 - sum, " %d %d", static_cast<int>(m_chunked.total()), static_cast<int>(m_chunked.index()));
-	}
+	obuf.moveWrite(pklen);
+	return ssize_t(pklen);
+}
 
-	if ( not m_appendix.empty() )
+std::string&
+MsgPacket::writeBinary(std::string& os) const
+{
+	if ( m_appendix.size() > size_t(limit_type::MAX_HEADER_SIZE) - BINARY_HEADER_SIZE )
 	{
-		char* p(b.buf+sum);
-		*p = ' ';
-		::memcpy(p+1, m_appendix.c_str(), m_appendix.size());
-		sum += m_appendix.size() + 1;
+		PWLOGLIB("too long appendix: input:%zu", m_appendix.size());
+		os.clear();
+		return os;
 	}
 
-	::memcpy(b.buf+sum, "\r\n", 2);
-	sum += 2;
+	os.resize(getBinaryPacketSize());
+	char* p(_putBinaryHeader(const_cast<char*>(os.data()), *this));
+	if ( m_body.size ) ::memcpy(p, m_body.buf, m_body.size);
 
-	if ( m_body.size )
-	{
-		::memcpy(b.buf+sum, m_body.buf, m_body.size);
-		sum += m_body.size;
-	}
+	return os;
+}
 
-	obuf.moveWrite(sum);
-	if ( sum not_eq pklen )
-	{
-		PWABORT("packet length is incorrect: pklen:%zd sum:%zd", pklen, sum);
-	}
+size_t
+MsgPacket::getPacketSize(void) const
+{
+	return _getTextHeaderSize(*this) + m_body.size;
+}
 
-	return sum;
+ssize_t
+MsgPacket::write(IoBuffer& obuf) const
+{
+	PWSHOWMETHOD();
+	const size_t hlen(_getTextHeaderSize(*this));
+	const size_t pklen(hlen + m_body.size);
+
+	IoBuffer::blob_type b;
+	if ( not obuf.grabWrite(b, pklen) ) return ssize_t(-1);
+
+	char* p(_putTextHeader(b.buf, *this));
+	if ( m_body.size ) ::memcpy(p, m_body.buf, m_body.size);
+
+	obuf.moveWrite(pklen);
+	return ssize_t(pklen);
 }
 
 std::string&
 MsgPacket::write(std::string& os) const
 {
 	PWSHOWMETHOD();
-	std::stringstream ss;
-	this->write(ss);
-	ss.str().swap(os);
+	os.resize(getPacketSize());
+
+	char* p(_putTextHeader(const_cast<char*>(os.data()), *this));
+	if ( m_body.size ) ::memcpy(p, m_body.buf, m_body.size);
+
 	return os;
 }
 
@@ -251,27 +492,48 @@ std::ostream&
 MsgPacket::write(std::ostream& os) const
 {
 	PWSHOWMETHOD();
-	char strflags[3+1];
+	std::string header(_getTextHeaderSize(*this), 0x00);
+	_putTextHeader(const_cast<char*>(header.data()), *this);
 
-	os << m_code << ' '
-		<< static_cast<int>(m_trid) << ' '
-		<< _uint82str(strflags, m_flags) << ' '
-		<< m_body.size;
+	os.write(header.c_str(), header.size());
+	if ( m_body.size > 0 ) os.write(m_body.buf, m_body.size);
 
-	if ( isFlagChunked() )
-	{
-		os << ' ' << m_chunked.total() << ' ' << m_chunked.index();
-	}
+	return os;
+}
 
-	if ( not m_appendix.empty() )
+size_t
+MsgPacket::getHeaderSize(bool binary) const
+{
+	if ( not binary ) return _getTextHeaderSize(*this);
+	if ( m_appendix.size() > size_t(limit_type::MAX_HEADER_SIZE) - BINARY_HEADER_SIZE ) return 0;
+	return size_t(BINARY_HEADER_SIZE) + m_appendix.size();
+}
+
+char*
+MsgPacket::writeHeader(char* p, bool binary) const
+{
+	return binary ? _putBinaryHeader(p, *this) : _putTextHeader(p, *this);
+}
+
+IoBuffer::shared_blob_type
+MsgPacket::makeImage(bool binary) const
+{
+	if ( binary and (m_appendix.size() > size_t(limit_type::MAX_HEADER_SIZE) - BINARY_HEADER_SIZE) )
 	{
-		os << ' ' << m_appendix;
+		PWLOGLIB("too long appendix: input:%zu", m_appendix.size());
+		return IoBuffer::shared_blob_type();
 	}
 
-	os.write("\r\n", 2);
-	if ( m_body.size > 0 ) os.write(m_body.buf, m_body.size);
+	const size_t pklen(binary ? getBinaryPacketSize() : getPacketSize());
 
-	return os;
+	std::shared_ptr<blob_type> img(std::make_shared<blob_type>());
+	if ( not img->allocate(pklen) ) return IoBuffer::shared_blob_type();
+
+	char* p(const_cast<char*>(img->buf));
+	p = binary ? _putBinaryHeader(p, *this) : _putTextHeader(p, *this);
+	if ( m_body.size ) ::memcpy(p, m_body.buf, m_body.size);
+
+	return img;
 }
 
 std::ostream&
@@ -39,6 +39,8 @@ namespace pw {
 
 //! \brief 메시지 패킷
 //! [CODE:4] [TRID:5] [FLAGS:3] [BODY_LENGTH:7]( [CHUNKED_TOTAL] [CHUNKED_INDEX] [APPENDIX])\\r\\n([BODY])
+//! \details 바이너리 헤더는 정수를 리틀 엔디언으로 쓰는 고정 길이 헤더이다.
+//! [MAGIC:1] [FLAGS:1] [TRID:2] [CODE:4] [BODY_LENGTH:4] [CHUNKED_TOTAL:2] [CHUNKED_INDEX:2] [APPENDIX_LENGTH:2] [RESERVED:2]([APPENDIX])([BODY])
 class MsgPacket : public PacketInterface
 {
 public:
@@ -56,6 +58,13 @@ public:
 		COMPRESSED = 0,
 		ENCRYPTED,
 		CHUNKED,
+		BINARY,	//!< 보낸 쪽이 바이너리 헤더를 받을 수 있다.
+	};
+
+	enum
+	{
+		BINARY_MAGIC = 0xB5,	//!< 바이너리 헤더의 첫 바이트. 텍스트 헤더의 첫 글자로 쓰지 않는다.
+		BINARY_HEADER_SIZE = 20,	//!< 바이너리 헤더의 고정 길이
 	};
 
 	//! \brief 나눠 받을 때 청크 정보
@@ -119,12 +128,30 @@ public:
 	//! \brief 패킷을 압축하였는가?
 	inline bool isFlagCompressed(void) const { return this->getFlag(flag_type::COMPRESSED); }
 
+	//! \brief 보낸 쪽이 바이너리 헤더를 받을 수 있는가?
+	inline bool isFlagBinary(void) const { return this->getFlag(flag_type::BINARY); }
+
 public:
 	//! \brief 헤더를 파싱해서 설정한다.
 	//! \param[in] buf 헤더
 	//! \param[in] blen 헤더 길이
+	//! \param[in] alloc_body 바디 버퍼를 할당한다. 거짓이면 바디 버퍼는 nullptr이고 크기만 설정한다.
+	//! \return 성공하면 true를 반환한다.
+	bool setHeader(const char* buf, size_t blen, bool alloc_body = true);
+
+	//! \brief 바이너리 헤더인지 첫 바이트로 확인한다.
+	inline static bool s_isBinaryHeader(const char* buf, size_t blen) { return ( (blen > 0) and (uint8_t(buf[0]) == uint8_t(BINARY_MAGIC)) ); }
+
+	//! \brief 바이너리 헤더 전체 길이를 구한다. APPENDIX를 포함한다.
+	//! \return 고정 길이만큼 받지 못했으면 0을 반환한다.
+	static size_t s_getBinaryHeaderSize(const char* buf, size_t blen);
+
+	//! \brief 바이너리 헤더를 파싱해서 설정한다.
+	//! \param[in] buf 헤더
+	//! \param[in] blen 헤더 길이. s_getBinaryHeaderSize 이상이어야 한다.
+	//! \param[in] alloc_body 바디 버퍼를 할당한다. 거짓이면 바디 버퍼는 nullptr이고 크기만 설정한다.
 	//! \return 성공하면 true를 반환한다.
-	bool setHeader(const char* buf, size_t blen);
+	bool setBinaryHeader(const char* buf, size_t blen, bool alloc_body = true);
 
 	//! \brief 코드와 트랜젝션 아이디만 복제한다. 응답을 만들 때 용이하다.
 	inline void setCodeTrid(const MsgPacket& pk) { m_code = pk.m_code; m_trid = pk.m_trid; }
@@ -148,6 +175,27 @@ public:
 	std::string& write(std::string&) const;
 	ssize_t write(IoBuffer&) const;
 
+	//! \brief 바이너리 헤더로 직렬화한 패킷 사이즈를 구한다.
+	size_t getBinaryPacketSize(void) const;
+
+	//! \brief 바이너리 헤더로 직렬화한다.
+	std::string& writeBinary(std::string&) const;
+	ssize_t writeBinary(IoBuffer&) const;
+
+	//! \brief 헤더 길이를 구한다. 바디는 포함하지 않는다.
+	//! \return 바이너리 헤더로 쓸 수 없으면 0을 반환한다.
+	size_t getHeaderSize(bool binary = false) const;
+
+	//! \brief 헤더만 쓰고 바디를 쓸 위치를 반환한다.
+	//! \details 바디를 바꿔 쓸 때 사용한다. m_body.size는 바꿔 쓸 바디의 길이여야 하고,
+	//!	p에는 getHeaderSize만큼 공간이 있어야 한다.
+	char* writeHeader(char* p, bool binary = false) const;
+
+	//! \brief 한 번 직렬화한 이미지를 만든다. PacketImage로 감싸 여러 채널에 보낼 수 있다.
+	//! \param[in] binary 바이너리 헤더로 직렬화한다.
+	//! \return 실패하면 빈 포인터를 반환한다.
+	IoBuffer::shared_blob_type makeImage(bool binary = false) const;
+
 	//! \brief 패킷을 덤프한다.
 	std::ostream& dump(std::ostream& os) const;
 
@@ -43,6 +43,37 @@ sigALRM(int)
 	// interrupt for system calls
 }
 
+//! \brief 브로드캐스트할 패킷을 한 번만 직렬화해서 채널마다 이미지를 공유한다.
+//! \details 바이너리 헤더로 보내는 채널이 섞여 있을 수 있으므로 이미지는 형식별로 필요할 때 만든다.
+class _BroadcastImage final
+{
+public:
+	inline explicit _BroadcastImage(const PacketInterface& pk) : m_pk(pk), m_msg(dynamic_cast<const MsgPacket*>(&pk)) {}
+
+	//! \brief 채널에 보낼 패킷. 이미지를 만들지 못하면 원래 패킷을 반환한다.
+	const PacketInterface& get(const MsgChannel& ch)
+	{
+		// 압축이나 암호화는 채널마다 하므로 공유하지 않는다.
+		if ( m_msg and (ch.isCompress() or ch.isCrypto()) ) return m_pk;
+
+		const bool binary( (nullptr not_eq m_msg) and ch.isBinarySending() );
+		std::unique_ptr<PacketImage>& img(m_img[binary ? 1 : 0]);
+		if ( not img )
+		{
+			if ( m_msg ) img.reset(new PacketImage(m_msg->makeImage(binary)));
+			else img.reset(new PacketImage(m_pk));
+		}
+
+		if ( img->empty() ) return m_pk;
+		return *img;
+	}
+
+private:
+	const PacketInterface&		m_pk;
+	const MsgPacket* const		m_msg;
+	std::unique_ptr<PacketImage>	m_img[2];	//!< 텍스트, 바이너리
+};
+
 //------------------------------------------------------------------------------
 // Multi Channel Pool
 
@@ -229,6 +260,18 @@ MultiChannelPool::s_create(const create_param_type& _param)
 		// 호스트별 채널 개수
 		const size_t count_dup(conf.getInteger("count.dup", sec, 0));
 
+		// 바이너리 헤더 사용 여부
+		const bool binary(conf.getBoolean("binary", sec, false));
+
+		// 바디 압축 레벨. 음수면 압축하지 않는다.
+		const int compress_level(conf.getInteger("compress.level", sec, -1));
+
+		// CHUNKED 패킷을 모을 최대 크기
+		const size_t chunk_limit(conf.getInteger("chunk.limit", sec, 0));
+
+		// 브로드캐스트 이미지를 복사하지 않고 참조로 보내도록 체인 쓰기 버퍼를 사용한다.
+		if ( conf.getBoolean("wbuf.chain", sec, false) ) param.param.wbuf_type = IoBuffer::Type::CHAIN;
+
 		if ( 0 == count )
 		{
 			PWTRACE("no multi channel: tag:%s secname:%s", param.tag.c_str(), secname);
@@ -273,6 +316,13 @@ MultiChannelPool::s_create(const create_param_type& _param)
 						break;
 					}
 
+					if ( binary ) pch->setBinaryFraming(true);
+					if ( chunk_limit ) pch->setChunkLimit(chunk_limit);
+					if ( (compress_level >= 0) and (not pch->setCompress(compress_level)) )
+					{
+						PWLOGLIB("failed to set compress: tag:%s level:%d", param.tag.c_str(), compress_level);
+					}
+
 					tmp_cont.push_back(pch);
 					pool->add(pch);
 				}// for dup
@@ -339,6 +389,7 @@ MultiChannelPool::~MultiChannelPool()
 size_t
 MultiChannelPool::broadcastFull(const PacketInterface& pk, ch_list* pout)
 {
+	_BroadcastImage img(pk);
 	if ( pout ) pout->clear();
 	size_t count(0);
 
@@ -352,7 +403,7 @@ MultiChannelPool::broadcastFull(const PacketInterface& pk, ch_list* pout)
 			for ( chhost_type::ch_itr ib_ch(chhost.cont.begin()), ie_ch(chhost.cont.end()); ib_ch not_eq ie_ch; ib_ch++ )
 			{
 				pch = *ib_ch;
-				pch->write(pk);
+				pch->write(img.get(*pch));
 				++count;
 				if ( pout ) pout->push_back(pch);
 			}
@@ -365,6 +416,7 @@ MultiChannelPool::broadcastFull(const PacketInterface& pk, ch_list* pout)
 size_t
 MultiChannelPool::broadcastPerHost(const PacketInterface& pk, ch_list* pout)
 {
+	_BroadcastImage img(pk);
 	if ( pout ) pout->clear();
 	size_t count(0);
 
@@ -377,7 +429,7 @@ MultiChannelPool::broadcastPerHost(const PacketInterface& pk, ch_list* pout)
 			chhost_type& chhost(ib_grp->second);
 			if ( nullptr not_eq (pch = chhost.getNext()) )
 			{
-				pch->write(pk);
+				pch->write(img.get(*pch));
 				++count;
 				if ( pout ) pout->push_back(pch);
 			}
@@ -390,6 +442,7 @@ MultiChannelPool::broadcastPerHost(const PacketInterface& pk, ch_list* pout)
 size_t
 MultiChannelPool::broadcastPerGroup(const PacketInterface& pk, ch_list* pout)
 {
+	_BroadcastImage img(pk);
 	if ( pout ) pout->clear();
 	size_t count(0);
 
@@ -399,7 +452,7 @@ MultiChannelPool::broadcastPerGroup(const PacketInterface& pk, ch_list* pout)
 		chgroup_type& grp(ib_pool->second);
 		if ( nullptr not_eq (pch = grp.getNext()) )
 		{
-			pch->write(pk);
+			pch->write(img.get(*pch));
 			++count;
 			if ( pout ) pout->push_back(pch);
 		}
@@ -573,11 +626,16 @@ MultiChannelInterface::eventConnect(void)
 {
 	MsgPacket pk;
 	bool flag_send(true), flag_wait(true);
+
+	// 새 접속이므로 상대가 응답할 때까지 텍스트 헤더로 보낸다.
+	m_binary_send = false;
+
 	if ( getHelloPacket(pk, flag_send, flag_wait) )
 	{
 		PWTRACE("getHelloPacket: flag_send:%d flag_wait:%d", int(flag_send), int(flag_wait));
 		if ( flag_send )
 		{
+			if ( isBinaryFraming() ) pk.setFlag(MsgPacket::flag_type::BINARY, true);
 			write(pk);
 		}
 
@@ -646,8 +704,12 @@ MultiChannelInterface::connectSync(void)
 			break;
 		}
 
+		m_binary_send = false;
+
 		if ( flag_send )
 		{
+			if ( isBinaryFraming() ) pk.setFlag(MsgPacket::flag_type::BINARY, true);
+
 			std::string dump;
 			pk.write(dump);
 
@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2015 SK PLANET. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file pw_notifier.cpp
+ * \brief Cross-thread wakeup for IoPoller.
+ * \copyright Copyright (c) 2015, SK PLANET. All Rights Reserved.
+ * \license This project is released under the MIT License.
+ */
+
+#include "./pw_notifier.h"
+#include "./pw_log.h"
+
+#include <fcntl.h>
+#ifdef HAVE_EVENTFD
+#	include <sys/eventfd.h>
+#endif
+
+namespace pw {
+
+Notifier::~Notifier()
+{
+	close(true);
+}
+
+bool
+Notifier::open(IoPoller* poller)
+{
+	close(true);
+
+	do {
+#ifdef HAVE_EVENTFD
+		if ( -1 == (m_fd[0] = ::eventfd(0, EFD_NONBLOCK bitor EFD_CLOEXEC)) )
+		{
+			PWLOGLIB("failed to create eventfd: %s", strerror(errno));
+			break;
+		}
+		m_fd[1] = m_fd[0];
+#else
+		if ( -1 == ::pipe(m_fd) )
+		{
+			PWLOGLIB("failed to create pipe: %s", strerror(errno));
+			m_fd[0] = m_fd[1] = -1;
+			break;
+		}
+
+		for ( auto fd : m_fd )
+		{
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) bitor O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+#endif
+
+		if ( not poller->add(m_fd[0], this, POLLIN) )
+		{
+			PWLOGLIB("failed to add notifier to poller: fd:%d", m_fd[0]);
+			break;
+		}
+
+		m_poller = poller;
+		m_pending = false;
+		return true;
+	} while (false);
+
+	close(false);
+	return false;
+}
+
+void
+Notifier::close(bool use_poller)
+{
+	if ( -1 == m_fd[0] ) return;
+
+	if ( use_poller and m_poller ) m_poller->remove(m_fd[0]);
+	m_poller = nullptr;
+
+	if ( m_fd[1] not_eq m_fd[0] ) ::close(m_fd[1]);
+	::close(m_fd[0]);
+	m_fd[0] = m_fd[1] = -1;
+}
+
+bool
+Notifier::notify(void)
+{
+	if ( m_pending.exchange(true) ) return true;
+
+	const int fd(m_fd[1]);
+	if ( -1 == fd ) return false;
+
+#ifdef HAVE_EVENTFD
+	const uint64_t v(1);
+#else
+	const char v(1);
+#endif
+	if ( (-1 == ::write(fd, &v, sizeof(v))) and (EAGAIN not_eq errno) )
+	{
+		m_pending = false;
+		return false;
+	}
+
+	return true;
+}
+
+void
+Notifier::eventIo(int fd, int, bool&)
+{
+	char buf[64];
+	while ( ::read(fd, buf, sizeof(buf)) > 0 ) {}
+
+	// 처리 중에 들어온 알림을 놓치지 않도록 먼저 해제한다.
+	m_pending = false;
+	eventNotify();
+}
+
+};//namespace pw
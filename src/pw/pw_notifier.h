@@ -0,0 +1,140 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2015 SK PLANET. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*!
+ * \file pw_notifier.h
+ * \brief Cross-thread wakeup for IoPoller.
+ * \copyright Copyright (c) 2015, SK PLANET. All Rights Reserved.
+ * \license This project is released under the MIT License.
+ */
+
+#include "./pw_common.h"
+#include "./pw_iopoller.h"
+#include "./pw_concurrentqueue_if.h"
+
+#include <atomic>
+
+#ifndef __PW_NOTIFIER_H__
+#define __PW_NOTIFIER_H__
+
+namespace pw {
+
+//! \brief 다른 스레드에서 폴러 스레드를 깨우는 알림 객체.
+//! \details eventfd를 폴러에 등록하고, 어느 스레드에서든 notify를 부르면
+//!	폴러 스레드에서 eventNotify가 호출된다. 처리 전에 여러 번 notify하면 한 번만 호출된다.
+//!	eventfd가 없는 시스템에서는 파이프를 사용한다.
+//! \warning open/close는 폴러 스레드에서만 호출한다.
+class Notifier : public IoPoller::Event
+{
+public:
+	explicit Notifier() = default;
+	virtual ~Notifier();
+
+	Notifier(const Notifier&) = delete;
+	Notifier& operator = (const Notifier&) = delete;
+
+public:
+	//! \brief 알림 fd를 만들어 폴러에 등록한다.
+	bool open(IoPoller* poller);
+
+	//! \brief 알림 fd를 닫는다.
+	//! \param[in] use_poller fork 후 자식에서는 폴러가 이미 없으므로 거짓으로 한다.
+	void close(bool use_poller = true);
+
+	//! \brief 폴러 스레드를 깨운다. 스레드에 안전하다.
+	bool notify(void);
+
+	//! \brief 등록한 폴러
+	inline IoPoller* getIoPoller(void) const { return m_poller; }
+
+	//! \brief 열려 있는지 여부
+	inline bool isOpen(void) const { return m_fd[0] not_eq -1; }
+
+protected:
+	//! \brief 폴러 스레드에서 호출한다.
+	virtual void eventNotify(void) = 0;
+
+private:
+	void eventIo(int fd, int event, bool& del_event) override;
+
+private:
+	IoPoller*	m_poller{nullptr};
+	int			m_fd[2]{-1, -1};	//!< 읽기, 쓰기. eventfd면 둘이 같다.
+	std::atomic<bool>	m_pending{false};	//!< 처리 전 알림이 있는지 여부
+};
+
+//! \brief 폴러에 등록하는 스레드 간 큐 템플릿
+//! \details 어느 스레드에서든 push하면 폴러 스레드에서 eventQueue가 넣은 순서대로 호출된다.
+//!	알림 fd를 폴러에 등록하므로 폴러 타임아웃을 기다리지 않고, 쌓인 것을 한 번에 처리한다.
+//!	폴러 없이 사용할 경우에는 dispatch를 직접 호출한다.
+template<typename _Type>
+class PollerQueueTemplate : public Notifier
+{
+public:
+	using value_type = _Type;						//!< Value type
+	using queue_type = MpscQueueTemplate<_Type>;	//!< Queue container
+
+public:
+	explicit PollerQueueTemplate() = default;
+	virtual ~PollerQueueTemplate() = default;
+
+public:
+	//! \brief 알림 fd를 폴러에 등록한다. 이미 쌓인 것이 있으면 바로 처리하도록 깨운다.
+	bool open(IoPoller* poller)
+	{
+		if ( not Notifier::open(poller) ) return false;
+		if ( not m_cont.empty() ) notify();
+		return true;
+	}
+
+	//! \brief 큐에 하나를 넣고 폴러 스레드를 깨운다. 스레드에 안전하다.
+	template<typename... _Args>
+	inline void push(_Args&&... args)
+	{
+		if ( m_cont.push(std::forward<_Args>(args)...) ) notify();
+	}
+
+	//! \brief 쌓인 것을 모두 처리한다. 폴러 스레드에서 호출한다.
+	//! \return 처리한 개수
+	inline size_t dispatch(void) { return m_cont.drain([this](value_type& v) { this->eventQueue(v); }); }
+
+	//! \brief 큐가 비어 있는지 확인한다.
+	inline bool empty(void) const { return m_cont.empty(); }
+
+	//! \brief 큐를 비운다. eventQueue를 호출하지 않는다.
+	inline void clear(void) { m_cont.clear(); }
+
+protected:
+	//! \brief 폴러 스레드에서 아이템마다 호출한다.
+	virtual void eventQueue(value_type& v) = 0;
+
+private:
+	void eventNotify(void) override { dispatch(); }
+
+private:
+	queue_type	m_cont;
+};
+
+};//namespace pw
+
+#endif//!__PW_NOTIFIER_H__
@@ -57,4 +57,26 @@ StlStringPacket::write(IoBuffer& obuf) const
 	return size;
 }
 
+PacketImage::PacketImage(const PacketInterface& pk)
+{
+	std::string tmp;
+	pk.write(tmp);
+	if ( not tmp.empty() ) m_image = std::make_shared<blob_type>(tmp, blob_type::CT_MALLOC);
+}
+
+std::ostream&
+PacketImage::write(std::ostream& os) const
+{
+	if ( not empty() ) os.write(m_image->buf, m_image->size);
+	return os;
+}
+
+std::string&
+PacketImage::write(std::string& ostr) const
+{
+	if ( empty() ) ostr.clear();
+	else ostr.assign(m_image->buf, m_image->size);
+	return ostr;
+}
+
 };//namespace pw
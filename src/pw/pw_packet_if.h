@@ -127,6 +127,34 @@ public:
 	std::string	m_body;
 };//StlStringPacket
 
+//! \brief 미리 직렬화한 패킷.
+//! \details 같은 패킷을 여러 채널에 보낼 때 한 번만 직렬화하고 이미지를 공유한다.
+//!	체인 버퍼에는 복사 없이 참조로 연결된다.
+class PacketImage final : public PacketInterface
+{
+public:
+	//! \brief 패킷을 직렬화해서 이미지를 만든다.
+	explicit PacketImage(const PacketInterface& pk);
+
+	//! \brief 이미 만든 이미지를 공유한다.
+	inline explicit PacketImage(const IoBuffer::shared_blob_type& image) : m_image(image) {}
+
+public:
+	inline ssize_t write (IoBuffer& buf) const override { return buf.writeToBuffer(m_image); }
+	std::ostream& write (std::ostream& os) const override;
+	std::string& write (std::string& ostr) const override;
+
+	inline void clear (void) override { m_image.reset(); }
+
+	inline bool empty(void) const { return ( (not m_image) or m_image->empty() ); }
+	inline size_t size(void) const { return m_image ? m_image->size : 0; }
+
+	inline const IoBuffer::shared_blob_type& getImage(void) const { return m_image; }
+
+private:
+	IoBuffer::shared_blob_type	m_image;
+};//PacketImage
+
 };// namespace pw
 
 #endif//!__PW_PACKET_IF_H__
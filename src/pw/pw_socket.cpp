@@ -48,6 +48,12 @@ typedef union cmsg_fd
 	char data[CMSG_SPACE(sizeof(int))];
 } cmsg_fd;
 
+typedef union cmsg_fds
+{
+	struct cmsghdr cmsg;
+	char data[CMSG_SPACE(sizeof(int) * Socket::MAX_MESSAGE_FD)];
+} cmsg_fds;
+
 inline
 static
 int64_t
@@ -340,6 +346,104 @@ Socket::s_sendMessage(int pipe_fd, int target_fd, const char* buf, size_t blen)
     return res;
 }
 
+ssize_t
+Socket::s_receiveMessage(int pipe_fd, int* target_fds, size_t& count, char* buf, size_t blen)
+{
+	const size_t max_count(std::min(count, size_t(MAX_MESSAGE_FD)));
+	count = 0;
+
+	struct msghdr msg;
+	struct iovec iov;
+	cmsg_fds cmsg;
+
+	iov.iov_base = buf;
+	iov.iov_len = blen;
+
+	msg.msg_name = nullptr;
+	msg.msg_namelen = 0;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	msg.msg_control = &cmsg;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * max_count);
+
+	msg.msg_flags = 0;
+
+	int flags(0);
+#if defined(MSG_CMSG_CLOEXEC)
+	flags = MSG_CMSG_CLOEXEC;
+#endif
+	ssize_t res(::recvmsg(pipe_fd, &msg, flags));
+	if ( -1 == res )
+	{
+		PWLOGLIB("failed to s_receiveMessage(%d): %s", errno, strerror(errno));
+		return -1;
+	}
+
+	const struct cmsghdr* cptr(CMSG_FIRSTHDR(&msg));
+	if ( nullptr == cptr )
+	{
+		PWLOGLIB("no cmsg 1st header: pid:%d", int(getpid()));
+		return -1;
+	}
+
+	if ( SOL_SOCKET not_eq cptr->cmsg_level or SCM_RIGHTS not_eq cptr->cmsg_type )
+	{
+		PWLOGLIB("invalid control message");
+		return -1;
+	}
+
+	// 공간이 모자라 잘린 FD는 커널이 닫는다.
+	if ( msg.msg_flags bitand MSG_CTRUNC ) PWLOGLIB("control message truncated: max:%zu", max_count);
+
+	count = (cptr->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+	memcpy(target_fds, CMSG_DATA(cptr), sizeof(int) * count);
+	return res;
+}
+
+ssize_t
+Socket::s_sendMessage(int pipe_fd, const int* target_fds, size_t count, const char* buf, size_t blen)
+{
+	if ( (0 == count) or (count > MAX_MESSAGE_FD) )
+	{
+		PWLOGLIB("invalid fd count: %zu", count);
+		return -1;
+	}
+
+	struct msghdr msg;
+	struct iovec iov;
+	cmsg_fds cmsg;
+
+	iov.iov_base = (void*)buf;
+	iov.iov_len = blen;
+
+	msg.msg_name = nullptr;
+	msg.msg_namelen = 0;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	msg.msg_control = &cmsg;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+	msg.msg_flags = 0;
+
+	struct cmsghdr* cptr(CMSG_FIRSTHDR(&msg));
+	cptr->cmsg_len = CMSG_LEN(sizeof(int) * count);
+	cptr->cmsg_level = SOL_SOCKET;
+	cptr->cmsg_type = SCM_RIGHTS;
+
+	memcpy(CMSG_DATA(cptr), target_fds, sizeof(int) * count);
+
+	ssize_t res(::sendmsg(pipe_fd, &msg, 0));
+	if ( -1 == res )
+	{
+		PWLOGLIB("failed to s_sendMessage(%d): %s", errno, strerror(errno));
+		return -1;
+	}
+
+	return res;
+}
+
 bool
 Socket::s_connect(int& sockfd, const char* host, const char* service, int family, bool async)
 {
@@ -405,14 +509,14 @@ Socket::s_connect(connect_param_type& param)
 	const host_type& host(param.in.host);
 	const bool async(param.in.async);
 
-	const int64_t to_start(Timer::s_getNow());
+	const int64_t to_start(Timer::s_readNow());
 	int fd(-1);
 	errno = 0;
 
 	const bool res(_try_connect(fd, host.host.c_str(), host.service.c_str(), param.in.family, true));
 	if ( res )
 	{
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 		param.out.fd = fd;
 		param.out.err = 0;
 		if ( not async ) s_setNonBlocking(fd, true);
@@ -420,7 +524,7 @@ Socket::s_connect(connect_param_type& param)
 	}
 	else if ( async or (fd == -1) )
 	{
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 		param.out.fd = fd;
 		param.out.err = errno;
 		return false;
@@ -431,7 +535,7 @@ Socket::s_connect(connect_param_type& param)
 	{
 		if ( fd not_eq -1 ) ::close(fd);
 
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 		param.out.fd = -1;
 		param.out.err = ( errno not_eq 0 ) ? errno : ETIMEDOUT;
 
@@ -449,7 +553,7 @@ Socket::s_connect(connect_param_type& param)
 		FD_SET(fd, &wfd);
 		if ( (selfd = select(fd+1, nullptr, &wfd, nullptr, ptv)) > 0 )
 		{
-			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 			param.out.fd = fd;
 			param.out.err = 0;
 
@@ -468,7 +572,7 @@ Socket::s_connect(connect_param_type& param)
 
 	if ( fd not_eq -1 ) ::close(fd);
 
-	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 	param.out.fd = -1;
 	param.out.err = ( errno not_eq 0 ) ? errno : ETIMEDOUT;
 
@@ -485,7 +589,7 @@ Socket::s_receive(io_param_type& param)
 	const int fd(param.in.fd);
 	const int flag(param.in.flag);
 
-	const int64_t to_start(Timer::s_getNow());
+	const int64_t to_start(Timer::s_readNow());
 	errno = 0;
 
 	ssize_t ret(-1);
@@ -496,13 +600,13 @@ Socket::s_receive(io_param_type& param)
 		{
 			out_size = static_cast<size_t>(ret);
 			param.out.err = 0;
-			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 			return true;
 		}
 
 		out_size = 0;
 		param.out.err = errno;
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 		return false;
 	}
 
@@ -522,7 +626,7 @@ Socket::s_receive(io_param_type& param)
 			{
 				out_size = static_cast<size_t>(ret);
 				param.out.err = 0;
-				param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+				param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 				return true;
 			}
 
@@ -539,7 +643,7 @@ Socket::s_receive(io_param_type& param)
 
 	out_size = 0;
 	param.out.err = errno;
-	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 
 	return false;
 }
@@ -554,7 +658,7 @@ Socket::s_send(io_param_type& param)
 	const int fd(param.in.fd);
 	const int flag(param.in.flag);
 
-	const int64_t to_start(Timer::s_getNow());
+	const int64_t to_start(Timer::s_readNow());
 	errno = 0;
 
 	ssize_t ret(-1);
@@ -565,13 +669,13 @@ Socket::s_send(io_param_type& param)
 		{
 			out_size = static_cast<size_t>(ret);
 			param.out.err = 0;
-			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 			return true;
 		}
 
 		out_size = 0;
 		param.out.err = errno;
-		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+		param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 		return false;
 	}
 
@@ -598,7 +702,7 @@ Socket::s_send(io_param_type& param)
 				{
 					out_size = in_size;
 					param.out.err = 0;
-					param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+					param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 					return true;
 				}
 
@@ -607,7 +711,7 @@ Socket::s_send(io_param_type& param)
 
 			out_size = in_size - left_size;
 			param.out.err = errno;
-			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 			return true;
 		}
 		else if ( selfd == 0 )
@@ -615,7 +719,7 @@ Socket::s_send(io_param_type& param)
 			errno = ETIMEDOUT;
 			out_size = in_size - left_size;
 			param.out.err = errno;
-			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+			param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 			return false;
 		}
 		else if ( (errno == EINTR) or (errno == EAGAIN) ) continue;
@@ -624,7 +728,7 @@ Socket::s_send(io_param_type& param)
 
 	out_size = 0;
 	param.out.err = errno;
-	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_getNow() - to_start);
+	param.out.timeout = _set_leftTimeout(param.in.timeout, Timer::s_readNow() - to_start);
 
 	return false;
 }
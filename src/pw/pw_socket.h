@@ -88,6 +88,11 @@ public:
 		} in;
 	};
 
+	enum
+	{
+		MAX_MESSAGE_FD = 64,	//!< s_sendMessage, s_receiveMessage로 한 번에 넘길 수 있는 최대 FD 개수
+	};
+
 public:
 	// Socket utilities
 
@@ -122,6 +127,16 @@ public:
 	//!	소켓으로 다른 프로세스로부터 FD 받기.
 	static ssize_t s_receiveMessage(int pipe_fd, int& target_fd, char* buf, size_t blen);
 
+	//! \brief ::sendmsg 구현.
+	//!	소켓으로 다른 프로세스에 FD 여러 개를 한 번에 넘기기.
+	//! \param[in] count 넘길 FD 개수. MAX_MESSAGE_FD 이하.
+	static ssize_t s_sendMessage(int pipe_fd, const int* target_fds, size_t count, const char* buf, size_t blen);
+
+	//! \brief ::recvmsg 구현.
+	//!	소켓으로 다른 프로세스로부터 FD 여러 개를 한 번에 받기.
+	//! \param[inout] count 받을 수 있는 최대 개수를 넘기고, 받은 개수를 돌려받는다.
+	static ssize_t s_receiveMessage(int pipe_fd, int* target_fds, size_t& count, char* buf, size_t blen);
+
 	//! \brief 커넥트 구현.
 	//! \return 접속을 완료하면, true를 반환한다. Async 접속 연결 진행 중이면, false를 반환하고, errno를 EINPROGRESS로 설정한다.
 	static bool s_connect(int& sockfd, const char* host, const char* service, int family = PF_UNSPEC, bool async = false);
@@ -32,184 +32,500 @@
 #include "./pw_log.h"
 
 #include <sys/time.h>
+#include <time.h>
+#ifdef HAVE_TIMERFD
+#	include <sys/timerfd.h>
+#endif
 
 pw::Timer&	PWTimer(pw::Timer::s_getInstance());
 
 namespace pw {
 
+//! \brief 현재 스레드의 타이머 싱글톤이 소멸했는지 여부. 정적 객체 소멸 순서 대비.
+static thread_local bool s_timer_destroyed(false);
+
+//! \brief 시계 설정. 정적 객체 초기화 전에 상수로 초기화된다.
+static Timer::Clock s_clock(Timer::Clock::MONOTONIC);
+static clockid_t s_clock_id(CLOCK_MONOTONIC);
+static int64_t s_clock_offset(0);	//!< 시계를 바꿀 때 이어지도록 더하는 값(us)
+static bool s_clock_cache(true);
+
+//! \brief 스레드별 시간 캐시(us). s_refresh를 부르지 않은 스레드는 0이며 매번 시계를 읽는다.
+static thread_local int64_t t_clock_cached(0);
+
 Timer::Event::Event()
 {
-	Timer::s_getInstance().invalidateIterator();
 }
 
 Timer::Event::~Event()
 {
-	Timer::s_getInstance().invalidateIterator();
+	if ( not s_timer_destroyed ) Timer::s_getInstance().remove(this);
+}
+
+Timer::Timer() : m_current(s_getNow()), m_last_check(m_current), m_count(0), m_timerfd(*this)
+{
+	::memset(m_occupied, 0x00, sizeof(m_occupied));
+}
+
+Timer::~Timer()
+{
+	clear();
+	s_timer_destroyed = true;
+}
+
+bool
+Timer::_TimerFD::open(IoPoller* poller)
+{
+#ifdef HAVE_TIMERFD
+	if ( -1 == (m_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK bitor TFD_CLOEXEC)) )
+	{
+		PWLOGLIB("failed to create timerfd: %s", strerror(errno));
+		return false;
+	}
+
+	if ( not poller->add(m_fd, this, POLLIN) )
+	{
+		PWLOGLIB("failed to add timerfd to poller: fd:%d", m_fd);
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	m_poller = poller;
+	m_armed = -1;
+
+	return true;
+#else
+	PWLOGLIB("not supported timerfd");
+	return false;
+#endif
+}
+
+void
+Timer::_TimerFD::close(bool use_poller)
+{
+	if ( -1 == m_fd ) return;
+
+	if ( use_poller and m_poller ) m_poller->remove(m_fd);
+	::close(m_fd);
+
+	m_fd = -1;
+	m_poller = nullptr;
+	m_armed = -1;
+}
+
+void
+Timer::_TimerFD::arm(int64_t tick)
+{
+#ifdef HAVE_TIMERFD
+	if ( (-1 == m_fd) or (tick == m_armed) ) return;
+
+	struct itimerspec its;
+	::memset(&its, 0x00, sizeof(its));
+
+	if ( tick >= 0 )
+	{
+		// 밀리초 경계보다 일찍 깨어나지 않도록 마이크로초로 계산한다.
+		int64_t usec(tick * 1000LL - s_readNowMicro());
+		if ( usec < 1 ) usec = 1;
+
+		its.it_value.tv_sec = time_t(usec / 1000000LL);
+		its.it_value.tv_nsec = long((usec % 1000000LL) * 1000LL);
+	}
+
+	if ( -1 == ::timerfd_settime(m_fd, 0, &its, nullptr) )
+	{
+		PWLOGLIB("failed to set timerfd: fd:%d tick:%jd %s", m_fd, intmax_t(tick), strerror(errno));
+		return;
+	}
+
+	m_armed = tick;
+#endif
+}
+
+void
+Timer::_TimerFD::eventIo(int fd, int, bool&)
+{
+	uint64_t count;
+	while ( ::read(fd, &count, sizeof(count)) > 0 ) {}
+
+	m_armed = -1;
+	m_timer.check();
+}
+
+bool
+Timer::setPoller(IoPoller* poller)
+{
+	m_timerfd.close(true);
+	const bool ret( (nullptr == poller) or m_timerfd.open(poller) );
+
+	// 모드에 따라 여유가 달라지므로 이미 등록한 타이머의 만료 시각을 다시 계산한다.
+	for ( auto& client : m_clients )
+	{
+		for ( auto& ev : client.second )
+		{
+			event_type* node(ev.second);
+			_unlink(node);
+			node->expire = _getExpire(node->start, node->cycle);
+			_link(node);
+		}
+	}
+
+	m_timerfd.arm(_getNextTick());
+
+	return ret;
 }
 
 int64_t
-Timer::s_getNow(void)
+Timer::_getNextTick(void) const
 {
-	struct timeval tv;
-	gettimeofday(&tv, nullptr);
-	return int64_t((tv.tv_sec * 1000LL) + (tv.tv_usec / 1000LL));
+	int64_t ret(-1);
+
+	for ( int level(0); level < WHEEL_LEVEL; level++ )
+	{
+		const uint64_t occupied(m_occupied[level]);
+		if ( not occupied ) continue;
+
+		const int shift(WHEEL_BITS * level);
+		const int64_t base(m_current >> shift);
+
+		// 레벨 0은 현재 칸부터, 상위 레벨은 다음 칸부터 순서대로 본다.
+		const int from( int((base + (level ? 1 : 0)) bitand WHEEL_MASK) );
+		const uint64_t rot( from ? ((occupied >> from) bitor (occupied << (WHEEL_SIZE - from))) : occupied );
+		const int64_t dist( __builtin_ctzll(rot) + (level ? 1 : 0) );
+
+		// 상위 레벨은 칸이 내려오는(cascade) 시각에 깨어난다.
+		const int64_t tick( level ? ((base + dist) << shift) : (m_current + dist) );
+		if ( (ret < 0) or (tick < ret) ) ret = tick;
+	}
+
+	return ret;
+}
+
+int64_t
+Timer::s_readNowMicro(void)
+{
+	struct timespec ts;
+	::clock_gettime(s_clock_id, &ts);
+	return int64_t((ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000LL)) + s_clock_offset;
 }
 
 int64_t
 Timer::s_getNowMicro(void)
+{
+	if ( s_clock_cache and t_clock_cached ) return t_clock_cached;
+	return s_readNowMicro();
+}
+
+int64_t
+Timer::s_refresh(void)
+{
+	const int64_t now(s_readNowMicro());
+	if ( s_clock_cache ) t_clock_cached = now;
+	return now / 1000LL;
+}
+
+int64_t
+Timer::s_getWallNow(void)
+{
+	return s_getWallNowMicro() / 1000LL;
+}
+
+int64_t
+Timer::s_getWallNowMicro(void)
 {
 	struct timeval tv;
 	gettimeofday(&tv, nullptr);
 	return int64_t((tv.tv_sec * 1000000LL) + (tv.tv_usec));
 }
 
+void
+Timer::s_setClock(Clock clock)
+{
+	if ( clock == s_clock ) return;
+
+	clockid_t id(CLOCK_MONOTONIC);
+	switch(clock)
+	{
+	case Clock::MONOTONIC: id = CLOCK_MONOTONIC; break;
+#ifdef CLOCK_MONOTONIC_COARSE
+	case Clock::MONOTONIC_COARSE: id = CLOCK_MONOTONIC_COARSE; break;
+#else
+	case Clock::MONOTONIC_COARSE: id = CLOCK_MONOTONIC; break;
+#endif
+	case Clock::REALTIME: id = CLOCK_REALTIME; break;
+	}
+
+	// 이미 얻은 시간과 이어지도록 새 시계와의 차이를 보정한다.
+	const int64_t before(s_readNowMicro());
+	s_clock = clock;
+	s_clock_id = id;
+	s_clock_offset = 0;
+	s_clock_offset = before - s_readNowMicro();
+
+	if ( t_clock_cached ) t_clock_cached = before;
+}
+
+Timer::Clock
+Timer::s_getClock(void)
+{
+	return s_clock;
+}
+
+void
+Timer::s_setCache(bool cache)
+{
+	s_clock_cache = cache;
+	t_clock_cached = cache ? s_readNowMicro() : 0;
+}
+
+bool
+Timer::s_isCache(void)
+{
+	return s_clock_cache;
+}
+
 void
 Timer::clear(void)
 {
+	for ( auto& client : m_clients )
+	{
+		for ( auto& ev : client.second )
+		{
+			_unlink(ev.second);
+			delete ev.second;
+		}
+	}
+
 	m_clients.clear();
-	m_inv_itrs = true;
+	m_count = 0;
+	::memset(m_occupied, 0x00, sizeof(m_occupied));
+	m_current = m_last_check = s_getNow();
+
+	// fork 후 자식에서 호출하므로 폴러는 건드리지 않는다.
+	m_timerfd.close(false);
 }
 
-size_t
-Timer::check(void)
+bool
+Timer::_isWheelEmpty(void) const
 {
-	//PWSHOWMETHOD();
-	const int64_t	now(s_getNow());
-	auto diff(now - m_last_check);
-	if ( diff < 100LL )
+	for ( size_t i(0); i < WHEEL_LEVEL; i++ )
 	{
-		//PWTRACE("skip too short: diff:%jd", intmax_t(diff));
-		return 0;
+		if ( m_occupied[i] ) return false;
 	}
 
-	m_last_check = now;
+	return true;
+}
 
-	auto ib = m_clients.begin();
-	auto ie = m_clients.end();
-	event_cont::iterator ib_event, ie_event;
+void
+Timer::_link(event_type* node)
+{
+	int64_t expire(node->expire);
+	if ( expire < m_current ) expire = m_current;
 
-	intptr_t		last_client;
-	Event*			event{nullptr};
+	// 휠 범위를 넘으면 마지막 레벨 끝에 두고, 내려올 때 다시 계산한다.
+	const int64_t range(int64_t(1) << (WHEEL_BITS * WHEEL_LEVEL));
+	if ( (expire - m_current) >= range ) expire = m_current + range - 1;
 
-	size_t ret(0);
+	const uint64_t delta(uint64_t(expire - m_current));
+	int level(0);
+	while ( (level < (WHEEL_LEVEL - 1)) and (delta >= (uint64_t(1) << (WHEEL_BITS * (level + 1)))) ) ++level;
 
-	m_inv_itrs = false;
-	while ( ib not_eq ie )
-	{
-		last_client = ib->first;
-		event = reinterpret_cast<Event*>(ib->first);
+	const int slot( int((uint64_t(expire) >> (WHEEL_BITS * level)) bitand WHEEL_MASK) );
 
-		ib_event = ib->second.begin();
-		ie_event = ib->second.end();
+	m_wheel[level][slot].pushBack(node);
+	m_occupied[level] |= (uint64_t(1) << slot);
+	node->level = level;
+	node->slot = slot;
+}
 
-		++ib;	// --- ib 증가!!
+void
+Timer::_unlink(event_type* node)
+{
+	node->unlink();
 
-		while ( ib_event not_eq ie_event )
+	if ( node->level >= 0 )
+	{
+		if ( m_wheel[node->level][node->slot].isEmpty() )
 		{
-			event_type& e(ib_event->second);
-			if ( (now - (e.start + e.cycle)) >= 1000LL )
-			{
-				//PWTRACE("event: %p type: %s", event, typeid(*event).name());
+			m_occupied[node->level] and_eq compl (uint64_t(1) << node->slot);
+		}
 
-				e.start = now;
-				event->eventTimer(ib_event->first, e.param);
+		node->level = node->slot = -1;
+	}
+}
 
-				++ret;
-			}
+void
+Timer::_cascade(int64_t tick)
+{
+	for ( int level(1); level < WHEEL_LEVEL; level++ )
+	{
+		const int slot( int((uint64_t(tick) >> (WHEEL_BITS * level)) bitand WHEEL_MASK) );
+		event_type& head(m_wheel[level][slot]);
+
+		if ( m_occupied[level] bitand (uint64_t(1) << slot) )
+		{
+			m_occupied[level] and_eq compl (uint64_t(1) << slot);
 
-			// Event 추가 삭제가 일어날 경우 발생한다.
-			// 이터레이터를 재정비하고 루프를 다시 돈다.
-			// 중단점 기준으로 돌기 때문에 큰 이슈는 없다.
-			if ( m_inv_itrs )
+			while ( not head.isEmpty() )
 			{
-				m_inv_itrs = false;
-				ib = m_clients.lower_bound(last_client);
-				ie = m_clients.end();
-				break;
+				event_type* node(head.next);
+				node->unlink();
+				_link(node);
 			}
-
-			++ib_event;
 		}
+
+		// 상위 레벨은 이 레벨이 한 바퀴 돌았을 때만 내려온다.
+		if ( slot not_eq 0 ) break;
+	}
+}
+
+size_t
+Timer::_expire(event_type& head, int64_t now)
+{
+	// 콜백에서 다른 타이머를 지울 수 있으므로 별도 목록으로 옮긴 뒤 하나씩 꺼낸다.
+	event_type due;
+	while ( not head.isEmpty() )
+	{
+		event_type* node(head.next);
+		node->unlink();
+		node->level = node->slot = -1;
+		due.pushBack(node);
+	}
+
+	size_t ret(0);
+	while ( not due.isEmpty() )
+	{
+		event_type* node(due.next);
+		node->unlink();
+
+		// 콜백에서 지워질 수 있으므로 다음 주기를 먼저 등록한다.
+		node->start = now;
+		node->expire = _getExpire(now, node->cycle);
+		_link(node);
+
+		//PWTRACE("event: %p type: %s", node->event, typeid(*node->event).name());
+		node->event->eventTimer(node->id, node->param);
+
+		++ret;
 	}
 
 	return ret;
 }
 
-bool
-Timer::add(Event* e, int id, int64_t cycle, void* param)
+size_t
+Timer::check(void)
 {
-	const intptr_t key((intptr_t)e);
-	auto ib = m_clients.find(key);
+	//PWSHOWMETHOD();
+	const int64_t	now(s_getNow());
+	auto diff(now - m_last_check);
+	if ( (diff < CHECK_INTERVAL) and (not isPrecise()) )
+	{
+		//PWTRACE("skip too short: diff:%jd", intmax_t(diff));
+		return 0;
+	}
+
+	m_last_check = now;
 
-	if ( ib == m_clients.end() )
+	size_t ret(0);
+	while ( m_current <= now )
 	{
-		auto res = m_clients.insert(client_cont::value_type(key, event_cont()));
-		if ( res.second == false )
+		const int64_t tick(m_current);
+		const int idx( int(uint64_t(tick) bitand WHEEL_MASK) );
+
+		if ( 0 == idx )
 		{
-			PWLOGLIB("failed to insert timer event: e:%p id:%d cycle:%jd param:%p", e, id, intmax_t(cycle), param);
-			return false;
-		}
+			if ( _isWheelEmpty() )
+			{
+				m_current = now + 1;
+				break;
+			}
 
-		event_cont& ec(res.first->second);
+			_cascade(tick);
+		}
 
-		// 이후 코드는 insert 성공 여부와 상관 없이 반복자가 무효하다.
-		invalidateIterator();
+		m_current = tick + 1;
 
-		if ( false == ec.insert(event_cont::value_type(id, event_type(param, cycle, s_getNow()))).second )
+		if ( m_occupied[0] bitand (uint64_t(1) << idx) )
 		{
-			PWLOGLIB("failed to insert timer event: e:%p id:%d cycle:%jd param:%p", e, id, intmax_t(cycle), param);
-			m_clients.erase(ib);
-			return false;
+			m_occupied[0] and_eq compl (uint64_t(1) << idx);
+			ret += _expire(m_wheel[0][idx], now);
 		}
 
-		//PWTRACE("add new timer event: e:%p type:%s id:%d cycle:%jdms", e, typeid(*e).name(), id, cycle);
-		return true;
+		// 빈 칸은 건너뛴다. 다음 사용 칸이나 다음 바퀴 시작까지 이동한다.
+		const uint64_t rest( (idx == WHEEL_MASK) ? 0 : (m_occupied[0] bitand (compl uint64_t(0) << (idx + 1))) );
+		const int64_t next( rest ? (tick - idx + __builtin_ctzll(rest)) : ((tick bitor WHEEL_MASK) + 1) );
+		if ( next > m_current ) m_current = std::min(next, now + 1);
 	}
 
-	auto& ec = ib->second;
-	auto ib_event = ec.find(id);
+	if ( isPrecise() ) m_timerfd.arm(_getNextTick());
 
-	if ( ec.end() == ib_event )
-	{
-		if ( false == ec.insert(event_cont::value_type(id, event_type(param, cycle, s_getNow()))).second )
-		{
-			PWLOGLIB("failed to insert timer event: e:%p id:%d cycle:%jd param:%p", e, id, intmax_t(cycle), param);
-			return false;
-		}
+	return ret;
+}
+
+bool
+Timer::add(Event* e, int id, int64_t cycle, void* param)
+{
+	event_cont& ec(m_clients[e]);
+	auto res(ec.insert(event_cont::value_type(id, nullptr)));
+	event_type*& node(res.first->second);
 
-		invalidateIterator();
+	if ( res.second )
+	{
+		node = new event_type;
+		node->event = e;
+		node->id = id;
+		++m_count;
 		//PWTRACE("add new timer event: e:%p type:%s id:%d cycle:%jdms", e, typeid(*e).name(), id, cycle);
-		return true;
+	}
+	else
+	{
+		_unlink(node);
 	}
 
-	// 반복자를 건들지 않았으므로 invalidateIterator를 호출하지 않는다.
-	auto& et = ib_event->second;
-	et.param = param;
-	et.cycle = cycle;
-	et.start = s_getNow();
+	node->param = param;
+	node->cycle = cycle;
+	node->start = s_getNow();
+	node->expire = _getExpire(node->start, cycle);
+	_link(node);
+
+	if ( isPrecise() ) m_timerfd.arm(_getNextTick());
 
-	//PWTRACE("add new timer event: e:%p type:%s id:%d cycle:%jdms", e, typeid(*e).name(), id, cycle);
 	return true;
 }
 
 void
 Timer::remove(Event* e, int id)
 {
-	const auto key(reinterpret_cast<intptr_t>(e));
-	auto ib(m_clients.find(key));
+	auto ib(m_clients.find(e));
 	if ( ib == m_clients.end() ) return;
 
 	auto& ec(ib->second);
+	auto ib_event(ec.find(id));
+	if ( ib_event == ec.end() ) return;
+
+	_unlink(ib_event->second);
+	delete ib_event->second;
+	--m_count;
+
+	ec.erase(ib_event);
+	if ( ec.empty() ) m_clients.erase(ib);
+}
 
-	do {
-		auto ib_event(ec.find(id));
-		if ( ib_event == ec.end() ) return;
+void
+Timer::remove(Event* e)
+{
+	auto ib(m_clients.find(e));
+	if ( ib == m_clients.end() ) return;
 
-		ec.erase(ib_event);
-		if ( ec.empty() ) m_clients.erase(ib);
-	} while (false);
+	for ( auto& ev : ib->second )
+	{
+		_unlink(ev.second);
+		delete ev.second;
+		--m_count;
+	}
 
-	invalidateIterator();
+	m_clients.erase(ib);
 }
 
 /* namespace pw */
@@ -29,6 +29,7 @@
  */
 
 #include "./pw_common.h"
+#include "./pw_iopoller.h"
 
 #ifndef __PW_TIMER_H__
 #define __PW_TIMER_H__
@@ -37,7 +38,7 @@ namespace pw
 {
 
 //! \brief 타이머 클래스.
-//! \warning 싱글톤 객체이다.
+//! \warning 스레드마다 하나씩 가지는 싱글톤 객체이다. 이벤트는 등록한 스레드에서 발생한다.
 class Timer final
 {
 public:
@@ -59,15 +60,55 @@ public:
 	};
 
 public:
-	//! \brief 싱글톤 객체를 얻는다.
-	inline static Timer& s_getInstance(void) { static Timer inst; return inst; }
+	//! \brief 현재 스레드의 싱글톤 객체를 얻는다.
+	inline static Timer& s_getInstance(void) { static thread_local Timer inst; return inst; }
+
+	//! \brief 경과 시간 측정에 사용할 시계
+	enum class Clock
+	{
+		MONOTONIC,	//!< CLOCK_MONOTONIC
+		MONOTONIC_COARSE,	//!< CLOCK_MONOTONIC_COARSE. 해상도가 낮지만 빠르다.
+		REALTIME,	//!< CLOCK_REALTIME. NTP 보정에 따라 뒤로 갈 수 있다.
+	};
 
 	//! \brief 현재 시간을 밀리세컨드로 얻는다.
-	static int64_t s_getNow(void);
+	//! \details 경과 시간 측정용이며 기준점은 정해져 있지 않다.
+	//!	캐시를 사용하면 s_refresh로 갱신한 값을 반환한다.
+	inline static int64_t s_getNow(void) { return s_getNowMicro() / 1000LL; }
 
 	//! \brief 현재 시간을 마이크로세컨드로 얻는다.
 	static int64_t s_getNowMicro(void);
 
+	//! \brief 캐시를 거치지 않고 시계를 읽어 밀리세컨드로 얻는다.
+	//! \details 이벤트 루프 밖에서 블록하며 시간을 재는 곳에서 사용한다.
+	inline static int64_t s_readNow(void) { return s_readNowMicro() / 1000LL; }
+
+	//! \brief 캐시를 거치지 않고 시계를 읽어 마이크로세컨드로 얻는다.
+	static int64_t s_readNowMicro(void);
+
+	//! \brief 현재 스레드의 시간 캐시를 갱신한다.
+	//! \return 갱신한 시간(ms)
+	static int64_t s_refresh(void);
+
+	//! \brief 벽시계(UNIX epoch) 시간을 밀리세컨드로 얻는다. 로그나 날짜에 사용한다.
+	static int64_t s_getWallNow(void);
+
+	//! \brief 벽시계(UNIX epoch) 시간을 마이크로세컨드로 얻는다.
+	static int64_t s_getWallNowMicro(void);
+
+	//! \brief 시계를 바꾼다.
+	//! \details 이미 얻은 시간과 이어지도록 차이를 보정하므로 실행 중에 바꿔도 된다.
+	static void s_setClock(Clock clock);
+
+	//! \brief 사용 중인 시계
+	static Clock s_getClock(void);
+
+	//! \brief 시간 캐시 사용 여부를 설정한다.
+	static void s_setCache(bool cache);
+
+	//! \brief 시간 캐시 사용 여부
+	static bool s_isCache(void);
+
 	//! \brief 밀리세컨드를 struct timeval 객체로 변환한다.
 	inline static struct timeval& s_toTimeval(struct timeval& tv, int64_t milsec)
 	{
@@ -95,34 +136,117 @@ public:
 	//! \brief 타이머 이벤트를 검사 목록에서 제거한다.
 	void remove(Event* e, int id);
 
+	//! \brief 이벤트 객체의 모든 타이머를 제거한다.
+	void remove(Event* e);
+
 	//! \brief 타이머 이벤트를 목록을 비운다.
 	void clear(void);
 
+	//! \brief 등록된 타이머 개수
+	inline size_t getCount(void) const { return m_count; }
+
+	//! \brief 정밀 모드 설정.
+	//! \details timerfd를 폴러에 등록하여 다음 만료 시각에 정확히 깨어난다.
+	//!	정밀 모드에서는 주기에 여유를 더하지 않고, 검사 간격 제한도 없다.
+	//! \param[in] poller nullptr이면 정밀 모드를 끈다.
+	bool setPoller(IoPoller* poller);
+
+	//! \brief 정밀 모드 여부
+	inline bool isPrecise(void) const { return m_timerfd.m_fd not_eq -1; }
+
 private:
-	//! \brief 이벤트 관리객체
-	typedef struct event_type
+	//! \brief 계층 타이밍 휠.
+	//! 1ms 단위로 레벨마다 64칸이며, 레벨 L의 한 칸은 64^L ms이다.
+	//! 만료 시각이 가까워지면 아래 레벨로 내려오고(cascade), 레벨 0에서 발생한다.
+	enum
 	{
-		void*	param;
-		int64_t	cycle;
-		int64_t start;
+		WHEEL_BITS = 6,
+		WHEEL_SIZE = (1 << WHEEL_BITS),	//!< 레벨당 칸 수
+		WHEEL_MASK = (WHEEL_SIZE - 1),
+		WHEEL_LEVEL = 6,	//!< 레벨 수. 64^6 ms, 약 795일
+		CHECK_INTERVAL = 100,	//!< 최소 검사 간격(ms)
+		EXPIRE_SLACK = 1000,	//!< 주기에 더하는 여유(ms). 예전 검사 방식과 같은 시점에 발생한다.
+	};
 
-		inline event_type(void* _param, int64_t _cycle, int64_t _start) : param(_param), cycle(_cycle), start(_start) {}
+	//! \brief 이벤트 관리객체. 휠 칸의 이중 연결 리스트 노드이다.
+	typedef struct event_type
+	{
+		Event*		event{nullptr};
+		int			id{0};
+		void*		param{nullptr};
+		int64_t		cycle{0};
+		int64_t		start{0};
+		int64_t		expire{0};	//!< 만료 시각(ms)
+
+		event_type*	prev{this};
+		event_type*	next{this};
+		int			level{-1};	//!< 휠 레벨. 휠 밖이면 -1
+		int			slot{-1};	//!< 휠 칸
+
+		inline bool isEmpty(void) const { return ( next == this ); }
+		inline void unlink(void) { prev->next = next; next->prev = prev; prev = next = this; }
+		inline void pushBack(event_type* node) { node->prev = prev; node->next = this; prev->next = node; prev = node; }
 	} event_type;
 
-	using event_cont = std::map<int, event_type>;
-	using client_cont = std::map<intptr_t, event_cont>;	//<! key is Timer::Event*
+	using event_cont = std::map<int, event_type*>;
+	using client_cont = std::unordered_map<Event*, event_cont>;
+
+private:
+	//! \brief 정밀 모드용 timerfd 클라이언트
+	class _TimerFD final : public IoPoller::Event
+	{
+	public:
+		explicit _TimerFD(Timer& timer) : m_timer(timer) {}
+		virtual ~_TimerFD() = default;
+
+		bool open(IoPoller* poller);
+
+		//! \brief fork 후 자식에서는 폴러가 이미 없으므로 use_poller를 거짓으로 한다.
+		void close(bool use_poller);
+
+		//! \brief tick(ms)에 깨어나도록 설정한다. 음수면 해제한다.
+		void arm(int64_t tick);
+
+	private:
+		void eventIo(int fd, int event, bool& del_event) override;
+
+	private:
+		Timer&		m_timer;
+		IoPoller*	m_poller{nullptr};
+		int			m_fd{-1};
+		int64_t		m_armed{-1};	//!< 설정한 시각(ms)
+
+	friend class Timer;
+	};
 
 private:
-	inline void invalidateIterator(void) { m_inv_itrs = true; }
+	inline int64_t _getExpire(int64_t start, int64_t cycle) const
+	{
+		if ( isPrecise() ) return start + std::max(cycle, int64_t(1));
+		return start + cycle + EXPIRE_SLACK;
+	}
+
+	//! \brief 다음에 처리할 일이 있는 시각(ms). 없으면 -1.
+	int64_t _getNextTick(void) const;
+
+	void _link(event_type* node);
+	void _unlink(event_type* node);
+	void _cascade(int64_t tick);
+	size_t _expire(event_type& head, int64_t now);
+	bool _isWheelEmpty(void) const;
 
 private:
 	client_cont	m_clients;
+	event_type	m_wheel[WHEEL_LEVEL][WHEEL_SIZE];
+	uint64_t	m_occupied[WHEEL_LEVEL];	//!< 칸 사용 비트맵
+	int64_t		m_current;	//!< 다음에 처리할 시각(ms)
 	int64_t		m_last_check;
-	bool		m_inv_itrs;
+	size_t		m_count;
+	_TimerFD	m_timerfd;
 
 private:
-	explicit Timer() : m_last_check(s_getNow()), m_inv_itrs(false) {}
-	virtual ~Timer() {}
+	explicit Timer();
+	virtual ~Timer();
 
 friend class Event;
 };
@@ -155,6 +279,7 @@ TimerRemove(Timer::Event* e, int id)
 
 };//namespace pw
 
+//! \brief 메인 스레드의 타이머.
 extern pw::Timer&	PWTimer;
 
 #endif//!__PW_TIMER_H__
@@ -59,6 +59,7 @@
 #include "./pw_sockaddr.h"
 #include "./pw_iobuffer.h"
 #include "./pw_iopoller.h"
+#include "./pw_notifier.h"
 #include "./pw_socket.h"
 #include "./pw_packet_if.h"
 #include "./pw_channel_if.h"
@@ -14,7 +14,6 @@
 #include "./myinstance.h"
 
 MyInstance& INST(MyInstance::s_getInstance());
-pw::JobManager& JOBMAN(INST.m_job.man);
 pw::Ini& CONF(INST.m_config.conf);
 pw::Log& CMDLOG(INST.m_log.cmd);
 pw::Log& ERRLOG(INST.m_log.err);
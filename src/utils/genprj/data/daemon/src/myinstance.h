@@ -93,8 +93,8 @@ private:
 //! \brief Instance
 extern MyInstance& INST;
 
-//! \brief Job manager
-extern pw::JobManager& JOBMAN;
+//! \brief Job manager macro. Each reactor thread has its own in thread mode.
+#define JOBMAN (INST.getJobManager())
 
 //! \brief Configuration
 extern pw::Ini& CONF;
@@ -15,7 +15,7 @@ HttpDemoJob* HttpDemoJob::s_run(pw::ChannelInterface& caller_ch, void* param)
 {
 	PWSHOWFUNC();
 
-	auto pjob(new HttpDemoJob(caller_ch));
+	auto pjob(JOBMAN.create<HttpDemoJob>(caller_ch));
 	if ( nullptr == pjob ) return nullptr;
 
 	pw::host_type host("localhost", "80");